@@ -358,6 +358,7 @@ local function setup_os_specific_paths()
   local rex_decoder_path
   local sdk_path
   local setup_success = true
+  local use_wine = (os_name == "LINUX")
   
   if os_name == "MACINTOSH" then
     -- macOS specific paths and setup
@@ -393,12 +394,42 @@ local function setup_os_specific_paths()
     rex_decoder_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator .. "rex2decoder_win.exe"
     sdk_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator
   elseif os_name == "LINUX" then
-    rex_decoder_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator .. "rex2decoder_win.exe"
-    sdk_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator
-    renoise.app():show_status("Hi, Linux user, remember to have WINE installed.")
+    -- Use the native rex2decoder_linux when it has been built and a REX
+    -- backend library is available ($REX_BACKEND or rx2/librexbackend.so,
+    -- see rx2/build_linux.sh). Otherwise run the Windows decoder under Wine.
+    local rx2_folder = renoise.tool().bundle_path .. "rx2" .. separator
+    local native_path = rx2_folder .. "rex2decoder_linux"
+    local backend_path = os.getenv("REX_BACKEND")
+    if backend_path == nil or backend_path == "" then
+      backend_path = rx2_folder .. "librexbackend.so"
+    end
+    local native_file = io.open(native_path, "rb")
+    local backend_file = io.open(backend_path, "rb")
+    if native_file and backend_file then
+      rex_decoder_path = native_path
+      sdk_path = rx2_folder
+      use_wine = false
+      print("Using native rex2decoder_linux with REX backend: " .. backend_path)
+
+      local check_cmd = string.format('test -x "%s"', rex_decoder_path)
+      if os.execute(check_cmd) ~= 0 then
+        print("rex2decoder_linux is not executable. Setting +x permission.")
+        local chmod_cmd = string.format('chmod +x "%s"', rex_decoder_path)
+        if os.execute(chmod_cmd) ~= 0 then
+          print("Failed to set executable permission on rex2decoder_linux")
+          setup_success = false
+        end
+      end
+    else
+      rex_decoder_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator .. "rex2decoder_win.exe"
+      sdk_path = renoise.tool().bundle_path .. "rx2" .. separator .. separator
+      renoise.app():show_status("Hi, Linux user, remember to have WINE installed.")
+    end
+    if native_file then native_file:close() end
+    if backend_file then backend_file:close() end
   end
   
-  return setup_success, rex_decoder_path, sdk_path
+  return setup_success, rex_decoder_path, sdk_path, use_wine
 end
 
 --------------------------------------------------------------------------------
@@ -754,7 +785,7 @@ function rx2_to_pti_convert_original(rx2_filename_override)
   print("-- Source RX2 file: " .. rx2_filename)
 
   -- Set up OS-specific paths and requirements
-  local setup_success, rex_decoder_path, sdk_path = setup_os_specific_paths()
+  local setup_success, rex_decoder_path, sdk_path, use_wine = setup_os_specific_paths()
   if not setup_success then
     renoise.app():show_status("Failed to setup RX2 decoder paths")
     return
@@ -801,7 +832,7 @@ function rx2_to_pti_convert_original(rx2_filename_override)
 
   -- Build and run the command to execute the external decoder
   local cmd
-  if os_name == "LINUX" then
+  if use_wine then
     cmd = string.format("wine %q %q %q %q %q 2>&1", 
       rex_decoder_path,  -- decoder executable
       rx2_filename,      -- input file
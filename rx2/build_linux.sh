@@ -0,0 +1,47 @@
+#!/bin/bash
+# Native Linux build: rex2decoder_linux talks to the REX API through a
+# backend library loaded at run time (rex_backend_loader.cpp), so the
+# decoder itself no longer needs Wine. The backend is found through
+# $REX_BACKEND, the sdk_path argument (a .so file or a directory holding
+# librexbackend.so).
+#
+# Propellerhead ships no Linux REX library, so Linux users have to supply
+# the backend: a shared library exporting rex_backend_entry() as
+# declared in rex_backend.h (for example a bridge to the Windows DLL).
+# Put rex2decoder_linux and that library, named librexbackend.so, in
+# this folder, or point $REX_BACKEND at the library. PakettiRX2Loader.lua
+# then runs rex2decoder_linux directly. Without both it keeps running
+# rex2decoder_win.exe under Wine.
+#
+# Also builds librexbackend_stub.so, the stub backend from stub/, for
+# offline runs and benchmarks:
+#   ./rex2decoder_linux --bench-batch 256,4096 stub/example.rx2stub ./librexbackend_stub.so
+#
+#   ./build_linux.sh                  build both
+#   ./build_linux.sh test [--update]  build, then check rex2decoder_linux on
+#                                     the stub backend against stub/expected
+#   ./build_linux.sh bench            build, then time the preview render
+
+${CXX:-c++} \
+  -std=c++17 -O2 -pthread \
+  rex2decoder.cpp \
+  rex_backend_loader.cpp \
+  -o rex2decoder_linux \
+  -I stub \
+  -ldl || exit 1
+
+${CXX:-c++} \
+  -std=c++17 -O2 -shared -fPIC \
+  -fvisibility=hidden \
+  -DREX_STUB_BACKEND=1 \
+  stub/REXStub.cpp \
+  -o librexbackend_stub.so \
+  -I stub || exit 1
+
+case "${1:-}" in
+  test|bench)
+    # The stub backend, even if $REX_BACKEND names another one
+    unset REX_BACKEND
+    exec stub/regress.sh ./rex2decoder_linux "$(pwd)/librexbackend_stub.so" "$@"
+    ;;
+esac
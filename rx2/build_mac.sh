@@ -1,12 +1,11 @@
 #!/bin/bash
 
 clang++ \
-  -std=c++17 \
+  -std=c++17 -O2 \
   -arch x86_64 \
   -arch arm64 \
-  rex2decoder_mac.cpp \
+  rex2decoder.cpp \
   REX.c \
-  Wav.c \
   -o rex2decoder_mac \
   -I ./ \
   -I /Users/esaruoho/Downloads/rx2/REXSDK_Mac_1.9.2 \
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Builds rex2decoder against the stub REX backend in stub/ instead of the
+# REX SDK. The result reads "REXSTUB 1" descriptors rather than .rx2 files
+# and is meant for offline benchmarking and regression runs on any POSIX
+# host (Linux included), not for shipping.
+#
+#   ./build_stub.sh                  build rex2decoder_stub
+#   ./build_stub.sh test [--update]  build, then check the outputs against
+#                                    stub/expected (see stub/regress.sh)
+#   ./build_stub.sh bench            build, then time the preview render
+
+${CXX:-c++} \
+  -std=c++17 -O2 -pthread \
+  rex2decoder.cpp \
+  stub/REXStub.cpp \
+  -o rex2decoder_stub \
+  -I stub || exit 1
+
+case "${1:-}" in
+  test|bench) exec stub/regress.sh ./rex2decoder_stub stub "$@" ;;
+esac
@@ -0,0 +1,5053 @@
+// rex2decoder.cpp
+//
+// REX2 (.rx2) to WAV + slice marker decoder, built from this one source
+// for every platform:
+//   macOS    build_mac.sh / build_mac_ARM64_only.sh (REX SDK, REX.c)
+//   Windows  build_win.sh (mingw, REX SDK, REX.c)
+//   Linux    build_linux.sh (native, REX API loaded from a backend library
+//            through rex_backend_loader.cpp, no Wine needed for the decoder)
+//   any      build_stub.sh (stub REX backend, for offline benchmarking)
+// Windows code paths are selected with _WIN32, macOS-only diagnostics
+// with DREX_MAC; everything else is POSIX.
+
+// If building for macOS, enable Darwin extensions.
+#if defined(DREX_MAC) && (DREX_MAC == 1)
+  #define _DARWIN_C_SOURCE 1
+  #include <CoreFoundation/CoreFoundation.h>
+#endif
+
+#if defined(_WIN32)
+  #include <winsock2.h>
+  #include <windows.h>
+  #include <shlobj.h>
+  #include <wchar.h>
+  #include <io.h>
+  #include <fcntl.h>
+  #include <psapi.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <unistd.h>
+  #include <csignal>
+  #include <sys/resource.h>
+#endif
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
+#if defined(DREX_MAC) && (DREX_MAC == 1)
+  #include <sys/xattr.h>
+  #include <dlfcn.h>
+#endif
+
+#include "REX.h"
+
+using namespace std;
+
+// Default latency compensation for preview rendering (--latency N overrides
+// it, --latency auto measures it per file).
+// Positive values shift markers later, negative values shift them earlier
+const int PREVIEW_LATENCY_COMPENSATION = -64; // Start with -64 frames (about 1.45ms at 44.1kHz)
+
+// Console verbosity, set once from --verbosity before any work starts.
+// Progress text is collected per job and written out in one go, so the
+// decode path never flushes the console.
+enum Verbosity {
+    kVerbositySilent = 0,   // errors and machine-readable status lines only
+    kVerbositySummary = 1,  // plus one header/summary block per file
+    kVerbosityDebug = 2     // plus the full per-slice analysis
+};
+Verbosity gVerbosity = kVerbositySilent;
+
+inline bool logSummary() { return gVerbosity >= kVerbositySummary; }
+inline bool logDebug() { return gVerbosity >= kVerbosityDebug; }
+
+// The SDK documents no thread safety, not even for separate handles, so
+// every REX:: call on a handle goes through sdkCall() and runs one at a
+// time. Parallel batch and probe jobs still overlap everything around
+// the calls: reading, PCM conversion, metering and file writes.
+// REXInitializeDLL_DirPath / REXUninitializeDLL run before the first and
+// after the last job and need no lock.
+mutex gSdkMutex;
+
+template <typename Function, typename... Args>
+auto sdkCall(Function function, Args&&... args) -> decltype(function(std::forward<Args>(args)...)) {
+    lock_guard<mutex> lock(gSdkMutex);
+    return function(std::forward<Args>(args)...);
+}
+
+// ---------------------------------------------------------------------
+// Pipeline statistics (--stats / --trace)
+// ---------------------------------------------------------------------
+// While a job runs with statistics enabled, its thread points tJobStats
+// at the job's record. StageTimer spans and statsAdd() counters add to
+// that record and cost nothing otherwise. Times are microseconds since
+// startup on the monotonic clock.
+bool gStatsEnabled = false; // set when --stats or --trace is given
+
+struct StageSpan {
+    const char* name;
+    int64_t startUs;
+    int64_t durationUs;
+};
+
+struct JobStats {
+    string input;
+    int thread = 0;
+    vector<StageSpan> spans;    // in the order the stages finished
+    uint64_t inputBytes = 0;    // RX2 bytes read
+    uint64_t outputBytes = 0;   // WAV, txt, metadata and export bytes written
+    uint64_t frames = 0;        // frames rendered
+    uint64_t sdkCalls = 0;      // REX API calls, render calls included
+    uint64_t renderCalls = 0;   // REXRenderPreviewBatch / REXRenderSlice calls
+};
+
+thread_local JobStats* tJobStats = nullptr;
+const chrono::steady_clock::time_point gStatsEpoch = chrono::steady_clock::now();
+
+int64_t statsNowUs() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - gStatsEpoch).count();
+}
+
+// Small stable number per thread, used as the trace's tid
+int statsThreadId() {
+    static atomic<int> nextId(1);
+    thread_local int id = nextId++;
+    return id;
+}
+
+inline void statsAdd(uint64_t JobStats::*counter, uint64_t amount) {
+    if (tJobStats) tJobStats->*counter += amount;
+}
+
+// Times the enclosing scope as one span of stage `name`.
+class StageTimer {
+public:
+    explicit StageTimer(const char* name) : mName(name), mStartUs(tJobStats ? statsNowUs() : 0) {}
+    ~StageTimer() { stop(); }
+
+    // Ends the span early; later calls (and the destructor) do nothing.
+    void stop() {
+        if (tJobStats && !mStopped) tJobStats->spans.push_back({ mName, mStartUs, statsNowUs() - mStartUs });
+        mStopped = true;
+    }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    const char* mName;
+    int64_t mStartUs;
+    bool mStopped = false;
+};
+
+// Peak resident memory of the whole process so far, in bytes
+uint64_t peakMemoryBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (uint64_t)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  #if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss;         // bytes on macOS
+  #else
+    return (uint64_t)usage.ru_maxrss * 1024;  // kilobytes elsewhere
+  #endif
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Utility functions for diagnostics and file/path checking
+// ---------------------------------------------------------------------
+#if defined(_WIN32)
+// Convert a UTF-8 char* string to std::wstring
+wstring ConvertToWide(const char* str) {
+    int len = MultiByteToWideChar(CP_UTF8, 0, str, -1, NULL, 0);
+    wstring wstr(len, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, str, -1, &wstr[0], len);
+    if (!wstr.empty() && wstr.back() == L'\0')
+        wstr.pop_back();
+    return wstr;
+}
+
+bool path_exists(const std::string& path) {
+    DWORD attrib = GetFileAttributesA(path.c_str());
+    return (attrib != INVALID_FILE_ATTRIBUTES);
+}
+bool path_is_directory(const std::string& path) {
+    DWORD attrib = GetFileAttributesA(path.c_str());
+    return (attrib != INVALID_FILE_ATTRIBUTES &&
+            (attrib & FILE_ATTRIBUTE_DIRECTORY));
+}
+#else
+bool path_exists(const std::string& path) {
+    struct stat buffer;
+    return stat(path.c_str(), &buffer) == 0;
+}
+bool path_is_directory(const std::string& path) {
+    struct stat buffer;
+    if (stat(path.c_str(), &buffer) != 0)
+        return false;
+    return S_ISDIR(buffer.st_mode);
+}
+#endif
+
+// "loops/out.wav" -> {"loops/out", ".wav"}; the extension is empty when
+// the last path component has no dot.
+pair<string, string> splitExtension(const string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return { path, string() };
+    return { path.substr(0, dot), path.substr(dot) };
+}
+
+void print_bundle_debug(const std::string& bundle_path) {
+    cout << "--- Bundle Diagnostics ---" << endl;
+    if (!path_exists(bundle_path)) {
+        cerr << "❌ Bundle path does not exist: " << bundle_path << endl;
+        return;
+    }
+    if (!path_is_directory(bundle_path)) {
+        cerr << "❌ Bundle path is not a directory: " << bundle_path << endl;
+        return;
+    }
+#if defined(DREX_MAC) && (DREX_MAC == 1)
+    std::string dylib_path = bundle_path + "/Contents/MacOS/REX Shared Library";
+    if (!path_exists(dylib_path)) {
+        cerr << "❌ Binary not found at: " << dylib_path << endl;
+    } else {
+        cout << "✅ Found binary: " << dylib_path << endl;
+        std::string cmd = "file \"" + dylib_path + "\"";
+        cout << "→ Running: " << cmd << endl;
+        system(cmd.c_str());
+        char quarantine[1024];
+        ssize_t len = getxattr(bundle_path.c_str(), "com.apple.quarantine",
+                                 quarantine, sizeof(quarantine), 0, 0);
+        if (len > 0) {
+            cout << "⚠️  Quarantine attribute found: ";
+            cout.write(quarantine, len);
+            cout << endl;
+        } else {
+            cout << "✅ No quarantine attribute found." << endl;
+        }
+        std::string codesign_cmd = "codesign --verify --deep --verbose=4 \"" + bundle_path + "\"";
+        cout << "→ Running codesign check..." << endl;
+        system(codesign_cmd.c_str());
+    }
+#elif defined(_WIN32)
+    // The DLL is expected in the provided folder as "REX Shared Library.dll".
+    string dll_path = bundle_path + "\\REX Shared Library.dll";
+    if (!path_exists(dll_path)) {
+        cerr << "❌ DLL not found at: " << dll_path << endl;
+    } else {
+        cout << "✅ Found DLL: " << dll_path << endl;
+    }
+#endif
+    cout << "---------------------------" << endl;
+}
+
+// ---------------------------------------------------------------------
+// WAV output: sample formats and float -> PCM conversion kernels
+// ---------------------------------------------------------------------
+enum SampleFormat {
+    kFormatSource,  // follow the REX file's bit depth
+    kFormatS16,
+    kFormatS24,
+    kFormatF32
+};
+SampleFormat gSampleFormat = kFormatSource;
+bool gDither = true; // TPDF dither for the integer formats
+
+SampleFormat resolveSampleFormat(const REX::REXInfo& info) {
+    if (gSampleFormat != kFormatSource) return gSampleFormat;
+    if (info.fBitDepth > 24) return kFormatF32;
+    if (info.fBitDepth > 16) return kFormatS24;
+    return kFormatS16;
+}
+
+const char* sampleFormatName(SampleFormat format) {
+    switch (format) {
+        case kFormatS24: return "s24";
+        case kFormatF32: return "f32";
+        default:         return "s16";
+    }
+}
+
+int sampleFormatBytes(SampleFormat format) {
+    switch (format) {
+        case kFormatS24: return 3;
+        case kFormatF32: return 4;
+        default:         return 2;
+    }
+}
+
+void putLE16(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+void putLE32(unsigned char* out, uint32_t value) {
+    putLE16(out, value & 0xFFFF);
+    putLE16(out + 2, value >> 16);
+}
+
+// Canonical 44-byte header; format tag 3 (IEEE float) for f32, 1 (PCM)
+// otherwise.
+void buildWavHeader(unsigned char header[44], int frames, int channels, SampleFormat format, int sampleRate) {
+    uint32_t blockAlign = (uint32_t)(channels * sampleFormatBytes(format));
+    uint32_t dataBytes = (uint32_t)frames * blockAlign;
+    memcpy(header, "RIFF", 4);
+    putLE32(header + 4, 36 + dataBytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, (format == kFormatF32) ? 3 : 1);
+    putLE16(header + 22, (uint32_t)channels);
+    putLE32(header + 24, (uint32_t)sampleRate);
+    putLE32(header + 28, (uint32_t)sampleRate * blockAlign);
+    putLE16(header + 32, blockAlign);
+    putLE16(header + 34, (uint32_t)(sampleFormatBytes(format) * 8));
+    memcpy(header + 36, "data", 4);
+    putLE32(header + 40, dataBytes);
+}
+
+// Deterministic TPDF dither source (xorshift32), so the same input always
+// produces byte-identical output. There is one per channel, which keeps the
+// output independent of how the frames are split into blocks.
+struct Ditherer {
+    uint32_t state;
+
+    explicit Ditherer(uint32_t seed) : state(seed ? seed : 0x9E3779B9u) {}
+
+    float uniform() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (float)(state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Triangular noise in (-1, 1) LSB
+    void fill(float* out, int n) {
+        for (int i = 0; i < n; i++) out[i] = uniform() - uniform();
+    }
+};
+
+// Scales, dithers, clamps and rounds n samples to integers in
+// [-scale, scale - 1].
+void quantizeBlock(const float* in, const float* dither, int32_t* out, int n, float scale) {
+    const float maxValue = scale - 1.0f;
+    const float minValue = -scale;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vScale = _mm_set1_ps(scale);
+    const __m128 vMax = _mm_set1_ps(maxValue);
+    const __m128 vMin = _mm_set1_ps(minValue);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), vScale), _mm_loadu_ps(dither + i));
+        v = _mm_min_ps(_mm_max_ps(v, vMin), vMax);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_cvtps_epi32(v));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t vScale = vdupq_n_f32(scale);
+    const float32x4_t vMax = vdupq_n_f32(maxValue);
+    const float32x4_t vMin = vdupq_n_f32(minValue);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vmlaq_f32(vld1q_f32(dither + i), vld1q_f32(in + i), vScale);
+        v = vminq_f32(vmaxq_f32(v, vMin), vMax);
+        vst1q_s32(out + i, vcvtnq_s32_f32(v));
+    }
+#endif
+    for (; i < n; i++) {
+        float v = in[i] * scale + dither[i];
+        if (v > maxValue) v = maxValue;
+        if (v < minValue) v = minValue;
+        out[i] = (int32_t)lrintf(v);
+    }
+}
+
+// Interleaves two quantized 16-bit channels into little-endian frames.
+void interleaveS16Stereo(const int32_t* left, const int32_t* right, int n, unsigned char* out) {
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(right + i));
+        __m128i frames = _mm_unpacklo_epi16(_mm_packs_epi32(l, l), _mm_packs_epi32(r, r));
+        _mm_storeu_si128((__m128i*)(out + i * 4), frames);
+    }
+#endif
+    for (; i < n; i++) {
+        putLE16(out + i * 4, (uint32_t)(uint16_t)left[i]);
+        putLE16(out + i * 4 + 2, (uint32_t)(uint16_t)right[i]);
+    }
+}
+
+// Converts `frames` planar float frames starting at `offset` into
+// interleaved bytes of the given format. Scratch buffers are owned by the
+// caller so a writer can reuse them across blocks.
+struct ConvertScratch {
+    vector<int32_t> quantized;
+    vector<float> dither;
+    vector<Ditherer> ditherers;
+};
+
+void convertBlock(float* const* buffers, int channels, int offset, int frames, SampleFormat format,
+                  ConvertScratch& scratch, unsigned char* out) {
+    if (format == kFormatF32) {
+        for (int f = 0; f < frames; f++) {
+            for (int c = 0; c < channels; c++) {
+                float value = buffers[c][offset + f];
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                putLE32(out + ((size_t)f * channels + c) * 4, bits);
+            }
+        }
+        return;
+    }
+
+    float scale = (format == kFormatS24) ? 8388608.0f : 32768.0f;
+    scratch.quantized.resize((size_t)frames * channels);
+    scratch.dither.resize(frames);
+    while ((int)scratch.ditherers.size() < channels) {
+        scratch.ditherers.emplace_back(0x9E3779B9u + 0x85EBCA6Bu * (uint32_t)scratch.ditherers.size());
+    }
+    for (int c = 0; c < channels; c++) {
+        if (gDither) {
+            scratch.ditherers[c].fill(scratch.dither.data(), frames);
+        } else {
+            fill(scratch.dither.begin(), scratch.dither.end(), 0.0f);
+        }
+        quantizeBlock(buffers[c] + offset, scratch.dither.data(), scratch.quantized.data() + (size_t)c * frames, frames, scale);
+    }
+
+    const int32_t* q = scratch.quantized.data();
+    if (format == kFormatS16 && channels == 2) {
+        interleaveS16Stereo(q, q + frames, frames, out);
+    } else if (format == kFormatS16) {
+        for (int f = 0; f < frames; f++) {
+            for (int c = 0; c < channels; c++) {
+                putLE16(out + ((size_t)f * channels + c) * 2, (uint32_t)(uint16_t)q[(size_t)c * frames + f]);
+            }
+        }
+    } else {
+        for (int f = 0; f < frames; f++) {
+            for (int c = 0; c < channels; c++) {
+                uint32_t value = (uint32_t)q[(size_t)c * frames + f];
+                unsigned char* sample = out + ((size_t)f * channels + c) * 3;
+                sample[0] = (unsigned char)(value & 0xFF);
+                sample[1] = (unsigned char)((value >> 8) & 0xFF);
+                sample[2] = (unsigned char)((value >> 16) & 0xFF);
+            }
+        }
+    }
+}
+
+const int kConvertBlockFrames = 4096;
+
+// Frames rendered per block by previewRenderFullLoop. Memory use is this
+// many frames per channel no matter how long the loop is.
+const int kRenderBlockFrames = 16384;
+
+// Writes planar float buffers (one per channel) as a WAV file.
+bool writeWavFile(const string& path, int frames, int channels, SampleFormat format, int sampleRate, float* const* buffers) {
+    FILE* outputFile = fopen(path.c_str(), "wb");
+    if (outputFile == nullptr) return false;
+
+    unsigned char header[44];
+    buildWavHeader(header, frames, channels, format, sampleRate);
+    bool ok = fwrite(header, 1, sizeof(header), outputFile) == sizeof(header);
+
+    ConvertScratch scratch;
+    vector<unsigned char> block((size_t)kConvertBlockFrames * channels * sampleFormatBytes(format));
+    for (int offset = 0; ok && offset < frames; offset += kConvertBlockFrames) {
+        int todo = min(kConvertBlockFrames, frames - offset);
+        convertBlock(buffers, channels, offset, todo, format, scratch, block.data());
+        size_t bytes = (size_t)todo * channels * sampleFormatBytes(format);
+        ok = fwrite(block.data(), 1, bytes, outputFile) == bytes;
+    }
+    return (fclose(outputFile) == 0) && ok;
+}
+
+// Streams converted blocks to disk. Two byte buffers alternate: while the
+// writer thread flushes one, the caller converts the next block into the
+// other. The header is written with a zero length first and patched with
+// the real frame count in finish(), so the total length needn't be known.
+// openStream() writes to a stream that can't seek (stdout, a memory
+// stream) instead: the frame count is given up front and the stream is
+// left open.
+class StreamingWavWriter {
+public:
+    StreamingWavWriter() {}
+    ~StreamingWavWriter() { finish(); }
+    StreamingWavWriter(const StreamingWavWriter&) = delete;
+    StreamingWavWriter& operator=(const StreamingWavWriter&) = delete;
+
+    bool open(const string& path, int channels, SampleFormat format, int sampleRate) {
+        mFile = fopen(path.c_str(), "wb");
+        if (mFile == nullptr) return false;
+        mOwnsFile = true;
+        start(channels, format, sampleRate, 0);
+        return true;
+    }
+
+    bool openStream(FILE* stream, int channels, SampleFormat format, int sampleRate, int frames) {
+        if (stream == nullptr) return false;
+        mFile = stream;
+        mOwnsFile = false;
+        start(channels, format, sampleRate, frames);
+        return true;
+    }
+
+    // Converts one block of planar float frames and queues it for writing.
+    // Only waits if the buffer it needs is still being written.
+    bool write(float* const* buffers, int frames) {
+        if (mFile == nullptr) return false;
+        int index = mFillIndex;
+        {
+            unique_lock<mutex> lock(mMutex);
+            mCond.wait(lock, [&]() { return !mBusy[index]; });
+            if (mError) return false;
+        }
+        size_t bytes = (size_t)frames * mChannels * sampleFormatBytes(mFormat);
+        if (mBuffers[index].size() < bytes) mBuffers[index].resize(bytes);
+        convertBlock(buffers, mChannels, 0, frames, mFormat, mScratch, mBuffers[index].data());
+        {
+            lock_guard<mutex> lock(mMutex);
+            mPending[index] = bytes;
+            mBusy[index] = true;
+        }
+        mCond.notify_all();
+        mFramesWritten += frames;
+        mFillIndex ^= 1;
+        return true;
+    }
+
+    // Drains the queue, patches the RIFF/data sizes and closes the file.
+    // A stream is only flushed, and must have received exactly the frame
+    // count its header announced.
+    bool finish() {
+        if (mFile == nullptr) return false;
+        {
+            lock_guard<mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCond.notify_all();
+        mThread.join();
+        bool ok = !mError;
+        if (!mOwnsFile) {
+            ok = (fflush(mFile) == 0) && ok && mFramesWritten == mStreamFrames;
+            mFile = nullptr;
+            return ok;
+        }
+        unsigned char header[44];
+        buildWavHeader(header, mFramesWritten, mChannels, mFormat, mSampleRate);
+        ok = ok && fseek(mFile, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), mFile) == sizeof(header);
+        ok = (fclose(mFile) == 0) && ok;
+        mFile = nullptr;
+        return ok;
+    }
+
+private:
+    // headerFrames is 0 for a file (patched in finish()), the final frame
+    // count for a stream.
+    void start(int channels, SampleFormat format, int sampleRate, int headerFrames) {
+        // A reused writer keeps its buffers but starts over on buffer 0
+        // with fresh dither state, so every file comes out the same.
+        mFillIndex = 0;
+        mScratch.ditherers.clear();
+        mChannels = channels;
+        mFormat = format;
+        mSampleRate = sampleRate;
+        mStreamFrames = headerFrames;
+        mFramesWritten = 0;
+        mError = false;
+        mStop = false;
+        unsigned char header[44];
+        buildWavHeader(header, headerFrames, mChannels, mFormat, mSampleRate);
+        if (fwrite(header, 1, sizeof(header), mFile) != sizeof(header)) {
+            mError = true;
+        }
+        mThread = thread(&StreamingWavWriter::writerLoop, this);
+    }
+
+    void writerLoop() {
+        int index = 0;
+        for (;;) {
+            unique_lock<mutex> lock(mMutex);
+            mCond.wait(lock, [&]() { return mBusy[index] || mStop; });
+            if (!mBusy[index]) break; // stopped and drained
+            size_t bytes = mPending[index];
+            lock.unlock();
+            bool ok = fwrite(mBuffers[index].data(), 1, bytes, mFile) == bytes;
+            lock.lock();
+            if (!ok) mError = true;
+            mBusy[index] = false;
+            lock.unlock();
+            mCond.notify_all();
+            index ^= 1;
+        }
+    }
+
+    FILE* mFile = nullptr;
+    bool mOwnsFile = true;
+    int mStreamFrames = 0;
+    int mChannels = 0;
+    SampleFormat mFormat = kFormatS16;
+    int mSampleRate = 0;
+    int mFramesWritten = 0;
+    ConvertScratch mScratch;
+    vector<unsigned char> mBuffers[2];
+    size_t mPending[2] = {0, 0};
+    bool mBusy[2] = {false, false};
+    int mFillIndex = 0;
+    bool mStop = false;
+    bool mError = false;
+    thread mThread;
+    mutex mMutex;
+    condition_variable mCond;
+};
+
+// Frames per REXRenderPreviewBatch call, set from --render-batch. The
+// default is the REX Test App's 64. Larger batches cut the SDK call count
+// by the same factor, but they haven't measured faster (the stub backend
+// is flat from 64 to 4096 frames), so --bench-batch is there to check a
+// real REX library before changing it.
+const int kDefaultRenderBatchFrames = 64;
+int gRenderBatchFrames = kDefaultRenderBatchFrames;
+
+// Renders `frames` preview frames into buffers[0..1] starting at `offset`,
+// in calls of at most `batchFrames`.
+REX::REXError renderPreviewFrames(REX::REXHandle handle, float* const* buffers, int offset, int frames,
+                                  int batchFrames, int* callCount = nullptr) {
+    int rendered = 0;
+    while (rendered != frames) {
+        int todo = min(batchFrames, frames - rendered);
+        float* tmpRenderBuffers[2] = {nullptr, nullptr};
+        tmpRenderBuffers[0] = buffers[0] + offset + rendered;
+        if (buffers[1] != nullptr) {
+            tmpRenderBuffers[1] = buffers[1] + offset + rendered;
+        }
+
+        REX::REXError result = sdkCall(REX::REXRenderPreviewBatch, handle, todo, tmpRenderBuffers);
+        if (callCount) (*callCount)++;
+        if (result != REX::kREXError_NoError) {
+            return result;
+        }
+        rendered += todo;
+    }
+    return REX::kREXError_NoError;
+}
+
+// Render target, set from --sample-rate / --tempo; 0 or an empty list
+// keeps the file's own rate or tempo. The SDK renders at the target
+// directly, so the output needs no resampling or stretching afterwards.
+// More than one tempo renders one variant of the loop per tempo.
+int gOutputSampleRate = 0;
+vector<int> gRenderTempos; // BPM * 1000
+
+int outputSampleRate(const REX::REXInfo& info) {
+    return (gOutputSampleRate > 0) ? gOutputSampleRate : info.fSampleRate;
+}
+
+// `tempo` if set, else the file's tempo
+int resolveTempo(const REX::REXInfo& info, int tempo) {
+    return (tempo > 0) ? tempo : info.fTempo;
+}
+
+// The first (usually only) render tempo
+int renderTempo(const REX::REXInfo& info) {
+    return resolveTempo(info, gRenderTempos.empty() ? 0 : gRenderTempos[0]);
+}
+
+// output.wav -> output_120bpm.wav, output_92.5bpm.wav; the extension (if
+// any) is kept.
+string tempoVariantPath(const string& path, int tempo) {
+    ostringstream bpm;
+    bpm << (tempo / 1000);
+    if (tempo % 1000 != 0) {
+        string fraction = to_string(1000 + tempo % 1000).substr(1);
+        while (fraction.back() == '0') fraction.pop_back();
+        bpm << "." << fraction;
+    }
+    auto [stem, extension] = splitExtension(path);
+    return stem + "_" + bpm.str() + "bpm" + extension;
+}
+
+// Preview length at `tempo` and the output sample rate (same formula as
+// REX Test App), before and after rounding to whole frames
+double previewLengthExact(const REX::REXInfo& info, int tempo) {
+    return (double)outputSampleRate(info) * 1000.0 * (double)info.fPPQLength / ((double)tempo * 256.0);
+}
+
+int previewLengthFrames(const REX::REXInfo& info, int tempo) {
+    return (int)round(previewLengthExact(info, tempo));
+}
+
+// The slice table of one REX handle, fetched once (one REXGetSliceInfo
+// per slice) and shared by every output: txt, metadata and slice WAVs.
+// Kept as struct-of-arrays so the marker pass runs over plain columns.
+// frameStart/frameEnd say where each slice landed in the rendered WAV
+// (after latency compensation); in slice mode they are offsets into the
+// concatenated slices. originalStart is only filled when --snap moved the
+// starts, and holds where they were before. effectiveLength is only filled
+// with --tails: each slice's length without its silent tail.
+struct SliceTable {
+    vector<int32_t> ppqPos;
+    vector<int32_t> sampleLength;
+    vector<int32_t> frameStart;
+    vector<int32_t> frameEnd;
+    vector<int32_t> originalStart;
+    vector<int32_t> effectiveLength;
+
+    size_t size() const { return ppqPos.size(); }
+    bool empty() const { return ppqPos.empty(); }
+    void resize(size_t n) {
+        ppqPos.resize(n);
+        sampleLength.resize(n);
+        frameStart.resize(n);
+        frameEnd.resize(n);
+    }
+};
+
+REX::REXError fetchSliceTable(REX::REXHandle handle, int sliceCount, SliceTable& table) {
+    StageTimer timer("slices");
+    table.resize(sliceCount > 0 ? (size_t)sliceCount : 0);
+    statsAdd(&JobStats::sdkCalls, table.size());
+    for (int i = 0; i < sliceCount; i++) {
+        REX::REXSliceInfo slice;
+        REX::REXError err = sdkCall(REX::REXGetSliceInfo, handle, i, sizeof(slice), &slice);
+        if (err != REX::kREXError_NoError) {
+            cerr << "REXGetSliceInfo failed for slice index " << i << " with error: " << err << endl;
+            table.resize(0);
+            return err;
+        }
+        table.ppqPos[i] = slice.fPPQPos;
+        table.sampleLength[i] = slice.fSampleLength;
+    }
+    return REX::kREXError_NoError;
+}
+
+// Frame of PPQ position `ppq` in a loop of lengthFrames frames spanning
+// ppqLength PPQ, rounded half up: round(ppq * lengthFrames / ppqLength)
+// in exact integer arithmetic.
+inline int32_t ppqToFrame(int64_t ppq, int64_t ppqLength, int64_t lengthFrames) {
+    return (int32_t)((2 * ppq * lengthFrames + ppqLength) / (2 * ppqLength));
+}
+
+// Given the unclamped starts in frameStart: end = the next slice's start,
+// or the end of the loop; start clamped to 1 for the marker.
+void finishLoopSliceFrames(SliceTable& table, int lengthFrames) {
+    size_t n = table.size();
+    if (n == 0) return;
+    int32_t* start = table.frameStart.data();
+    int32_t* end = table.frameEnd.data();
+    for (size_t i = 0; i + 1 < n; i++) end[i] = start[i + 1];
+    end[n - 1] = lengthFrames;
+    for (size_t i = 0; i < n; i++) start[i] = max(start[i], 1);
+}
+
+// Slice positions in the rendered loop, in branch-free passes over the
+// table: start = exact frame + that slice's latency (clamped to 1 for the
+// marker), end = the next slice's unclamped start, or the end of the loop.
+void computeLoopSliceFrames(SliceTable& table, int ppqLength, int lengthFrames, const vector<int32_t>& latency) {
+    size_t n = table.size();
+    if (n == 0) return;
+    const int32_t* ppq = table.ppqPos.data();
+    const int32_t* shift = latency.data();
+    int32_t* start = table.frameStart.data();
+    for (size_t i = 0; i < n; i++) start[i] = ppqToFrame(ppq[i], ppqLength, lengthFrames) + shift[i];
+    finishLoopSliceFrames(table, lengthFrames);
+}
+
+// Slice positions when the slices are laid out back to back.
+void computeConcatenatedSliceFrames(SliceTable& table) {
+    int32_t offset = 0;
+    for (size_t i = 0; i < table.size(); i++) {
+        table.frameStart[i] = offset;
+        offset += table.sampleLength[i];
+        table.frameEnd[i] = offset;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Preview latency: fixed or measured from the rendered loop
+// ---------------------------------------------------------------------
+// Set from --latency. The preview output is offset from the PPQ grid by
+// a few frames. kLatencyFixed shifts every marker by gLatencyFrames.
+// kLatencyAuto measures the offset per file: the median distance between
+// each slice's PPQ-derived frame and the onset detected near it.
+// kLatencyPerSlice places every marker on its own onset; slices without
+// a clear onset fall back to the per-file value.
+enum LatencyMode { kLatencyFixed, kLatencyAuto, kLatencyPerSlice };
+LatencyMode gLatencyMode = kLatencyFixed;
+int gLatencyFrames = PREVIEW_LATENCY_COMPENSATION;
+
+const char* latencyModeName(LatencyMode mode) {
+    switch (mode) {
+        case kLatencyAuto: return "auto";
+        case kLatencyPerSlice: return "auto-slice";
+        default: return "fixed";
+    }
+}
+
+// Frames searched on either side of a slice's PPQ-derived frame, and the
+// length of the energy windows compared before/after a candidate onset.
+const int kOnsetSearchFrames = 512;
+const int kOnsetWindowFrames = 64;
+
+// Mono power ((left + right) / 2)^2, or left^2 for mono input.
+void monoPowerBlock(const float* left, const float* right, float* out, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vHalf = _mm_set1_ps(0.5f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(left + i);
+        if (right) v = _mm_mul_ps(_mm_add_ps(v, _mm_loadu_ps(right + i)), vHalf);
+        _mm_storeu_ps(out + i, _mm_mul_ps(v, v));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(left + i);
+        if (right) v = vmulq_n_f32(vaddq_f32(v, vld1q_f32(right + i)), 0.5f);
+        vst1q_f32(out + i, vmulq_f32(v, v));
+    }
+#endif
+    for (; i < n; i++) {
+        float v = right ? (left[i] + right[i]) * 0.5f : left[i];
+        out[i] = v * v;
+    }
+}
+
+// Finds the onset in power[0..n): the point with the largest rise in
+// energy between the kOnsetWindowFrames before and after it, refined to
+// the first frame of that attack that stands out from the level before
+// it. Returns -1 if nothing in the window looks like an onset.
+int findOnset(const float* power, int n, vector<double>& prefix) {
+    const int w = kOnsetWindowFrames;
+    if (n < 2 * w) return -1;
+    prefix.resize((size_t)n + 1);
+    prefix[0] = 0.0;
+    for (int i = 0; i < n; i++) prefix[i + 1] = prefix[i] + power[i];
+
+    int best = -1;
+    double bestRise = 0.0;
+    for (int i = w; i <= n - w; i++) {
+        double after = prefix[i + w] - prefix[i];
+        double before = prefix[i] - prefix[i - w];
+        double rise = after - before;
+        // At least 6 dB louder than before, and above about -80 dBFS
+        if (rise > bestRise && after > 4.0 * before && after > w * 1e-8) {
+            bestRise = rise;
+            best = i;
+        }
+    }
+    if (best < 0) return -1;
+
+    float peak = *max_element(power + best, power + best + w);
+    double levelBefore = (prefix[best] - prefix[best - w]) / w;
+    float threshold = (float)max(16.0 * levelBefore, 0.0004 * peak); // 4x RMS before, -34 dB below peak
+    int onset = best;
+    if (power[onset] <= threshold) {
+        while (onset < best + w - 1 && power[onset] <= threshold) onset++;
+    } else {
+        while (onset > best - w && power[onset - 1] > threshold) onset--;
+    }
+    return onset;
+}
+
+// Collects mono power around every slice position while the loop is
+// rendered block by block, then locates the onsets.
+class OnsetCapture {
+public:
+    // rawFrames: PPQ-derived frame of every slice, ascending.
+    void begin(const vector<int32_t>& rawFrames) {
+        mStarts.resize(rawFrames.size());
+        for (size_t i = 0; i < rawFrames.size(); i++) mStarts[i] = rawFrames[i] - kOnsetSearchFrames;
+        mPower.assign(rawFrames.size() * kWindow, 0.0f);
+        mCursor = 0;
+    }
+
+    // Takes `frames` rendered frames that start at loop frame blockStart.
+    void feed(float* const* buffers, int blockStart, int frames) {
+        int blockEnd = blockStart + frames;
+        while (mCursor < mStarts.size() && mStarts[mCursor] + kWindow <= blockStart) mCursor++;
+        if (mCursor == mStarts.size() || mStarts[mCursor] >= blockEnd) return;
+        mScratch.resize(frames);
+        monoPowerBlock(buffers[0], buffers[1], mScratch.data(), frames);
+        for (size_t i = mCursor; i < mStarts.size() && mStarts[i] < blockEnd; i++) {
+            int from = max(mStarts[i], blockStart);
+            int to = min(mStarts[i] + kWindow, blockEnd);
+            if (from >= to) continue;
+            memcpy(&mPower[i * kWindow + (from - mStarts[i])], &mScratch[from - blockStart],
+                   (size_t)(to - from) * sizeof(float));
+        }
+    }
+
+    // Detected onset frame of slice i, or -1.
+    int onset(size_t i) {
+        int found = findOnset(&mPower[i * kWindow], kWindow, mPrefix);
+        return (found < 0) ? -1 : mStarts[i] + found;
+    }
+
+private:
+    static const int kWindow = 2 * kOnsetSearchFrames;
+    vector<int32_t> mStarts;
+    vector<float> mPower;
+    vector<float> mScratch;
+    vector<double> mPrefix;
+    size_t mCursor = 0;
+};
+
+// Per-slice latency for the selected mode. For the measured modes
+// `detected` receives the number of slices with a usable onset; the
+// returned per-file value is what kLatencyAuto applies to every slice.
+int resolveSliceLatency(OnsetCapture& capture, const vector<int32_t>& rawFrames,
+                        vector<int32_t>& latency, int& detected) {
+    size_t n = rawFrames.size();
+    latency.assign(n, gLatencyFrames);
+    detected = 0;
+    if (gLatencyMode == kLatencyFixed) return gLatencyFrames;
+
+    vector<int32_t> offsets(n, 0);
+    vector<bool> found(n, false);
+    vector<int32_t> sorted;
+    for (size_t i = 0; i < n; i++) {
+        int onset = capture.onset(i);
+        if (onset < 0) continue;
+        offsets[i] = onset - rawFrames[i];
+        found[i] = true;
+        sorted.push_back(offsets[i]);
+    }
+    detected = (int)sorted.size();
+    if (sorted.empty()) return gLatencyFrames;
+    nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    int fileLatency = sorted[sorted.size() / 2];
+    for (size_t i = 0; i < n; i++) {
+        latency[i] = (gLatencyMode == kLatencyPerSlice && found[i]) ? offsets[i] : fileLatency;
+    }
+    return fileLatency;
+}
+
+// ---------------------------------------------------------------------
+// Level analysis: peak, true peak, RMS and loudness while rendering
+// ---------------------------------------------------------------------
+// Set from --analyze / --normalize. The meter is fed the same blocks the
+// writer gets, so the levels cost no extra pass over the audio. Loudness
+// follows ITU-R BS.1770: the K-weighted mean square of the channels. The
+// loop's integrated value is gated over 400 ms blocks (-70 LUFS absolute,
+// -10 LU relative). Slices are usually shorter than one block, so a
+// slice gets the ungated value. True peak is the largest sample of the
+// signal oversampled 4x by a 12-tap windowed-sinc interpolator.
+//
+// --normalize scales the output to a true-peak or loudness target before
+// it is converted. The loop's level is only known once it has all been
+// rendered, so a normalized loop is rendered once, metered, into a float
+// temp file, then read back, scaled and converted into the real output.
+// In slice mode each slice is normalized on its own.
+enum NormalizeMode { kNormalizeNone, kNormalizePeak, kNormalizeLoudness };
+bool gAnalyze = false;
+NormalizeMode gNormalizeMode = kNormalizeNone;
+double gNormalizeTarget = 0.0; // dBTP or LUFS
+
+const int kTruePeakTaps = 12;
+const int kTruePeakDelay = kTruePeakTaps / 2; // frames the meter lags its input
+
+// Interpolator phases 1/4, 2/4 and 3/4 of the way from line[5] to line[6]
+// of a 12-sample line; Hann-windowed sinc, each phase normalized to unity
+// gain at DC.
+struct TruePeakFilter {
+    float coef[3][kTruePeakTaps];
+
+    TruePeakFilter() {
+        const double pi = 3.14159265358979323846;
+        for (int p = 0; p < 3; p++) {
+            double sum = 0.0;
+            double taps[kTruePeakTaps];
+            for (int k = 0; k < kTruePeakTaps; k++) {
+                double d = (k - (kTruePeakDelay - 1)) - (p + 1) / 4.0;
+                double sinc = sin(pi * d) / (pi * d);
+                taps[k] = sinc * (0.5 + 0.5 * cos(pi * d / kTruePeakDelay));
+                sum += taps[k];
+            }
+            for (int k = 0; k < kTruePeakTaps; k++) coef[p][k] = (float)(taps[k] / sum);
+        }
+    }
+};
+
+const TruePeakFilter& truePeakFilter() {
+    static const TruePeakFilter filter;
+    return filter;
+}
+
+// Per-frame power (sum of squares over the channels) and sample peak
+// (largest |x| over the channels). right is null for mono.
+void powerPeakBlock(const float* left, const float* right, int n, float* power, float* peak) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vAbs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= n; i += 4) {
+        __m128 l = _mm_loadu_ps(left + i);
+        __m128 p = _mm_mul_ps(l, l);
+        __m128 m = _mm_and_ps(l, vAbs);
+        if (right) {
+            __m128 r = _mm_loadu_ps(right + i);
+            p = _mm_add_ps(p, _mm_mul_ps(r, r));
+            m = _mm_max_ps(m, _mm_and_ps(r, vAbs));
+        }
+        _mm_storeu_ps(power + i, p);
+        _mm_storeu_ps(peak + i, m);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t l = vld1q_f32(left + i);
+        float32x4_t p = vmulq_f32(l, l);
+        float32x4_t m = vabsq_f32(l);
+        if (right) {
+            float32x4_t r = vld1q_f32(right + i);
+            p = vaddq_f32(p, vmulq_f32(r, r));
+            m = vmaxq_f32(m, vabsq_f32(r));
+        }
+        vst1q_f32(power + i, p);
+        vst1q_f32(peak + i, m);
+    }
+#endif
+    for (; i < n; i++) {
+        float p = left[i] * left[i];
+        float m = fabsf(left[i]);
+        if (right) {
+            p += right[i] * right[i];
+            m = max(m, fabsf(right[i]));
+        }
+        power[i] = p;
+        peak[i] = m;
+    }
+}
+
+// Raises truePeak[i] to the largest |y| of the three points interpolated
+// between line[i + 5] and line[i + 6]. line holds n + 11 samples.
+void truePeakBlock(const float* line, int n, float* truePeak) {
+    const TruePeakFilter& filter = truePeakFilter();
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vAbs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i + 4 <= n; i += 4) {
+        __m128 m = _mm_loadu_ps(truePeak + i);
+        for (int p = 0; p < 3; p++) {
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < kTruePeakTaps; k++) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(filter.coef[p][k]), _mm_loadu_ps(line + i + k)));
+            }
+            m = _mm_max_ps(m, _mm_and_ps(acc, vAbs));
+        }
+        _mm_storeu_ps(truePeak + i, m);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t m = vld1q_f32(truePeak + i);
+        for (int p = 0; p < 3; p++) {
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (int k = 0; k < kTruePeakTaps; k++) {
+                acc = vmlaq_n_f32(acc, vld1q_f32(line + i + k), filter.coef[p][k]);
+            }
+            m = vmaxq_f32(m, vabsq_f32(acc));
+        }
+        vst1q_f32(truePeak + i, m);
+    }
+#endif
+    for (; i < n; i++) {
+        float m = truePeak[i];
+        for (int p = 0; p < 3; p++) {
+            float acc = 0.0f;
+            for (int k = 0; k < kTruePeakTaps; k++) acc += filter.coef[p][k] * line[i + k];
+            m = max(m, fabsf(acc));
+        }
+        truePeak[i] = m;
+    }
+}
+
+// BS.1770 K-weighting (high shelf, then high pass) for one channel, with
+// the coefficients derived for the render's sample rate.
+class KWeighting {
+public:
+    void reset(int sampleRate) {
+        const double pi = 3.14159265358979323846;
+        double k = tan(pi * 1681.974450955533 / sampleRate);
+        double q = 0.7071752369554196;
+        double vh = pow(10.0, 3.999843853973347 / 20.0);
+        double vb = pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        mB[0][0] = (vh + vb * k / q + k * k) / a0;
+        mB[0][1] = 2.0 * (k * k - vh) / a0;
+        mB[0][2] = (vh - vb * k / q + k * k) / a0;
+        mA[0][0] = 2.0 * (k * k - 1.0) / a0;
+        mA[0][1] = (1.0 - k / q + k * k) / a0;
+
+        k = tan(pi * 38.13547087602444 / sampleRate);
+        q = 0.5003270373238773;
+        a0 = 1.0 + k / q + k * k;
+        mB[1][0] = 1.0;
+        mB[1][1] = -2.0;
+        mB[1][2] = 1.0;
+        mA[1][0] = 2.0 * (k * k - 1.0) / a0;
+        mA[1][1] = (1.0 - k / q + k * k) / a0;
+        memset(mState, 0, sizeof(mState));
+    }
+
+    // Adds the squared K-weighted samples of x[0..n) to weighted[0..n).
+    void addWeighted(const float* x, int n, float* weighted) {
+        for (int i = 0; i < n; i++) {
+            double y = x[i];
+            for (int s = 0; s < 2; s++) {
+                double out = mB[s][0] * y + mState[s][0];
+                mState[s][0] = mB[s][1] * y - mA[s][0] * out + mState[s][1];
+                mState[s][1] = mB[s][2] * y - mA[s][1] * out;
+                y = out;
+            }
+            weighted[i] += (float)(y * y);
+        }
+    }
+
+private:
+    double mB[2][3];
+    double mA[2][2];
+    double mState[2][2];
+};
+
+// Sums over a range of frames, from which the levels are derived.
+struct LevelSums {
+    double power = 0.0;    // x^2, summed over frames and channels
+    double weighted = 0.0; // K-weighted y^2, likewise
+    float peak = 0.0f;
+    float truePeak = 0.0f;
+    int64_t frames = 0;
+
+    void add(const LevelSums& other) {
+        power += other.power;
+        weighted += other.weighted;
+        peak = max(peak, other.peak);
+        truePeak = max(truePeak, other.truePeak);
+        frames += other.frames;
+    }
+};
+
+// The reported levels in dB. NAN where nothing was measured (the loop in
+// slice mode), -inf for digital silence; the metadata writes both as null.
+struct LevelStats {
+    double peak = NAN;     // dBFS
+    double truePeak = NAN; // dBTP
+    double rms = NAN;      // dBFS
+    double loudness = NAN; // LUFS; integrated for the loop, ungated for slices
+    double gain = 0.0;     // dB applied before the output was written
+};
+
+double linearToDb(double amplitude) {
+    return (amplitude > 0.0) ? 20.0 * log10(amplitude) : -INFINITY;
+}
+
+double meanSquareLoudness(double meanSquare) {
+    return (meanSquare > 0.0) ? -0.691 + 10.0 * log10(meanSquare) : -INFINITY;
+}
+
+LevelStats levelStats(const LevelSums& sums, int channels, double loudness) {
+    LevelStats stats;
+    stats.peak = linearToDb(sums.peak);
+    stats.truePeak = linearToDb(sums.truePeak);
+    double meanSquare = (sums.frames > 0) ? sums.power / ((double)sums.frames * channels) : 0.0;
+    stats.rms = (meanSquare > 0.0) ? 10.0 * log10(meanSquare) : -INFINITY;
+    stats.loudness = loudness;
+    return stats;
+}
+
+// Ungated loudness of a range of frames
+double rangeLoudness(const LevelSums& sums) {
+    return meanSquareLoudness(sums.frames > 0 ? sums.weighted / sums.frames : 0.0);
+}
+
+// Gain in dB that takes `stats` to the --normalize target; 0 for silence.
+double normalizeGain(const LevelStats& stats) {
+    double level = (gNormalizeMode == kNormalizePeak) ? stats.truePeak : stats.loudness;
+    if (gNormalizeMode == kNormalizeNone || !isfinite(level)) return 0.0;
+    return gNormalizeTarget - level;
+}
+
+// Shifts every level by the gain that was applied to the audio.
+void applyGain(LevelStats& stats, double gain) {
+    stats.peak += gain;
+    stats.truePeak += gain;
+    stats.rms += gain;
+    stats.loudness += gain;
+    stats.gain = gain;
+}
+
+void scaleBlock(float* const* buffers, int channels, int frames, float gain) {
+    for (int c = 0; c < channels; c++) {
+        float* samples = buffers[c];
+        for (int i = 0; i < frames; i++) samples[i] *= gain;
+    }
+}
+
+// Meters a loop fed block by block, for the loop as a whole and for any
+// frame range asked afterwards. Only the sums between the places where a
+// slice may start are kept, plus per-frame values within `radius` frames
+// of each of them: with a measured latency the slice starts are only
+// known after the render, and they are then looked up from those values.
+// The interpolator needs kTruePeakDelay frames of look-ahead, so the
+// meter runs that far behind its input until finish().
+class LevelMeter {
+public:
+    // centers: ascending frames where slices may start.
+    void begin(int sampleRate, int channels, int lengthFrames, const vector<int32_t>& centers, int radius) {
+        mChannels = channels;
+        mLength = lengthFrames;
+        mFed = 0;
+        mTotal = LevelSums();
+        for (int c = 0; c < channels; c++) {
+            mLines[c].assign(kTruePeakTaps - 1, 0.0f);
+            mWeighting[c].reset(sampleRate);
+        }
+        mHopFrames = max(1, sampleRate / 10);
+        mHops.assign((size_t)lengthFrames / mHopFrames + 1, 0.0);
+
+        mItems.clear();
+        size_t stored = 0;
+        int pos = 0;
+        for (int32_t center : centers) {
+            int from = max(pos, min(center - radius, lengthFrames));
+            int to = max(from, min(center + radius, lengthFrames));
+            mItems.push_back({ pos, from, false, 0, LevelSums() });
+            mItems.push_back({ from, to, true, stored, LevelSums() });
+            stored += (size_t)(to - from);
+            pos = to;
+        }
+        mItems.push_back({ pos, lengthFrames, false, 0, LevelSums() });
+        for (vector<float>* column : { &mWindowPower, &mWindowWeighted, &mWindowPeak, &mWindowTruePeak }) {
+            column->assign(stored, 0.0f);
+        }
+        mCursor = 0;
+    }
+
+    // Takes the next `frames` frames of the loop.
+    void feed(float* const* buffers, int frames) {
+        for (int c = 0; c < mChannels; c++) {
+            mLines[c].resize(kTruePeakTaps - 1 + (size_t)frames);
+            memcpy(&mLines[c][kTruePeakTaps - 1], buffers[c], (size_t)frames * sizeof(float));
+        }
+        process(mFed - kTruePeakDelay, frames);
+        mFed += frames;
+    }
+
+    // Meters the last kTruePeakDelay frames once the whole loop is in.
+    void finish() {
+        float silence[kTruePeakDelay] = {0.0f};
+        float* buffers[2] = { silence, silence };
+        feed(buffers, kTruePeakDelay);
+    }
+
+    const LevelSums& total() const { return mTotal; }
+
+    // BS.1770 gated loudness of the whole loop. A loop shorter than one
+    // 400 ms block is measured as a single block.
+    double integratedLoudness() const {
+        size_t hops = (size_t)mLength / mHopFrames;
+        if (hops < 4) return rangeLoudness(mTotal);
+        vector<double> blocks;
+        for (size_t i = 0; i + 4 <= hops; i++) {
+            double loudness = meanSquareLoudness((mHops[i] + mHops[i + 1] + mHops[i + 2] + mHops[i + 3]) / (4.0 * mHopFrames));
+            if (loudness > -70.0) blocks.push_back(loudness);
+        }
+        if (blocks.empty()) return -INFINITY;
+        auto gatedMean = [&](double gate) {
+            double sum = 0.0;
+            size_t count = 0;
+            for (double loudness : blocks) {
+                if (loudness > gate) { sum += pow(10.0, (loudness + 0.691) / 10.0); count++; }
+            }
+            return count ? meanSquareLoudness(sum / count) : -INFINITY;
+        };
+        return gatedMean(gatedMean(-70.0) - 10.0);
+    }
+
+    // Sums of frames [from, to). Both ends should be one of the centers
+    // or lie within `radius` of one; an end inside a stretch of kept sums
+    // counts as that stretch's start.
+    LevelSums range(int from, int to) const {
+        LevelSums sums;
+        from = max(from, 0);
+        to = min(to, mLength);
+        for (const Item& item : mItems) {
+            if (!item.window) {
+                if (item.start >= from && item.start < to) sums.add(item.sums);
+                continue;
+            }
+            for (int f = max(from, item.start); f < min(to, item.end); f++) {
+                size_t at = item.offset + (size_t)(f - item.start);
+                sums.power += mWindowPower[at];
+                sums.weighted += mWindowWeighted[at];
+                sums.peak = max(sums.peak, mWindowPeak[at]);
+                sums.truePeak = max(sums.truePeak, mWindowTruePeak[at]);
+                sums.frames++;
+            }
+        }
+        return sums;
+    }
+
+private:
+    // A stretch of the loop: summed, or kept per frame (window).
+    struct Item {
+        int start;
+        int end;
+        bool window;
+        size_t offset;
+        LevelSums sums;
+    };
+
+    // Meters `count` frames starting at loop frame `first` from the lines,
+    // then keeps the last 11 samples of each line as the next history.
+    void process(int first, int count) {
+        for (vector<float>* column : { &mPower, &mWeighted, &mPeak, &mTruePeak }) column->resize(count);
+        const float* center[2] = { mLines[0].data() + kTruePeakDelay - 1,
+                                   mChannels == 2 ? mLines[1].data() + kTruePeakDelay - 1 : nullptr };
+        powerPeakBlock(center[0], center[1], count, mPower.data(), mPeak.data());
+        memcpy(mTruePeak.data(), mPeak.data(), (size_t)count * sizeof(float));
+        fill(mWeighted.begin(), mWeighted.end(), 0.0f);
+        for (int c = 0; c < mChannels; c++) {
+            truePeakBlock(mLines[c].data(), count, mTruePeak.data());
+            mWeighting[c].addWeighted(center[c], count, mWeighted.data());
+        }
+        accumulate(first, max(first, 0), min(first + count, mLength));
+        for (int c = 0; c < mChannels; c++) {
+            memmove(mLines[c].data(), mLines[c].data() + count, (kTruePeakTaps - 1) * sizeof(float));
+            mLines[c].resize(kTruePeakTaps - 1);
+        }
+    }
+
+    // Adds the metered frames [from, to) (scratch index = frame - first).
+    void addSums(LevelSums& sums, int first, int from, int to) const {
+        for (int f = from; f < to; f++) {
+            sums.power += mPower[f - first];
+            sums.weighted += mWeighted[f - first];
+            sums.peak = max(sums.peak, mPeak[f - first]);
+            sums.truePeak = max(sums.truePeak, mTruePeak[f - first]);
+        }
+        sums.frames += max(0, to - from);
+    }
+
+    void accumulate(int first, int from, int to) {
+        if (from >= to) return;
+        addSums(mTotal, first, from, to);
+        for (int f = from; f < to; f++) mHops[f / mHopFrames] += mWeighted[f - first];
+        while (mCursor < mItems.size() && mItems[mCursor].end <= from) mCursor++;
+        for (size_t i = mCursor; i < mItems.size() && mItems[i].start < to; i++) {
+            Item& item = mItems[i];
+            int a = max(from, item.start);
+            int b = min(to, item.end);
+            if (a >= b) continue;
+            if (!item.window) {
+                addSums(item.sums, first, a, b);
+                continue;
+            }
+            size_t at = item.offset + (size_t)(a - item.start);
+            size_t n = (size_t)(b - a);
+            memcpy(&mWindowPower[at], &mPower[a - first], n * sizeof(float));
+            memcpy(&mWindowWeighted[at], &mWeighted[a - first], n * sizeof(float));
+            memcpy(&mWindowPeak[at], &mPeak[a - first], n * sizeof(float));
+            memcpy(&mWindowTruePeak[at], &mTruePeak[a - first], n * sizeof(float));
+        }
+    }
+
+    int mChannels = 0;
+    int mLength = 0;
+    int mFed = 0;
+    int mHopFrames = 1;
+    vector<float> mLines[2];
+    KWeighting mWeighting[2];
+    vector<float> mPower, mWeighted, mPeak, mTruePeak;
+    vector<double> mHops;
+    vector<Item> mItems;
+    vector<float> mWindowPower, mWindowWeighted, mWindowPeak, mWindowTruePeak;
+    size_t mCursor = 0;
+    LevelSums mTotal;
+};
+
+// ---------------------------------------------------------------------
+// Marker snapping: move slice starts onto zero crossings
+// ---------------------------------------------------------------------
+// Set from --snap zero-crossing[:N]. Each loop marker moves to the frame
+// nearest to it, at most gSnapFrames away, where every channel changes
+// sign at once. If no frame in the window does, it moves to the quietest
+// frame instead. The audio around every marker position is captured
+// during the render, like the onset windows, so snapping needs no second
+// pass. The unsnapped positions are kept in SliceTable::originalStart.
+bool gSnapZeroCrossing = false;
+const int kDefaultSnapFrames = 256;
+int gSnapFrames = kDefaultSnapFrames;
+
+// Zero-crossing cost of frames x[0..n), where x[-1] is the frame before:
+// 0 where every channel changes sign (or is exactly zero), else 1 + the
+// largest |x| over the channels. right is null for mono.
+void zeroCrossingCostBlock(const float* left, const float* right, int n, float* cost) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vAbs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 vZero = _mm_setzero_ps();
+    const __m128 vOne = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 cur = _mm_loadu_ps(left + i);
+        __m128 flip = _mm_xor_ps(cur, _mm_loadu_ps(left + i - 1));
+        __m128 cross = _mm_or_ps(_mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(flip), 31)), _mm_cmpeq_ps(cur, vZero));
+        __m128 level = _mm_and_ps(cur, vAbs);
+        if (right) {
+            cur = _mm_loadu_ps(right + i);
+            flip = _mm_xor_ps(cur, _mm_loadu_ps(right + i - 1));
+            cross = _mm_and_ps(cross, _mm_or_ps(_mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(flip), 31)),
+                                                _mm_cmpeq_ps(cur, vZero)));
+            level = _mm_max_ps(level, _mm_and_ps(cur, vAbs));
+        }
+        _mm_storeu_ps(cost + i, _mm_andnot_ps(cross, _mm_add_ps(vOne, level)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const int32x4_t vZeroBits = vdupq_n_s32(0);
+    const float32x4_t vZero = vdupq_n_f32(0.0f);
+    const float32x4_t vOne = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t cur = vld1q_f32(left + i);
+        int32x4_t flip = veorq_s32(vreinterpretq_s32_f32(cur), vreinterpretq_s32_f32(vld1q_f32(left + i - 1)));
+        uint32x4_t cross = vorrq_u32(vcltq_s32(flip, vZeroBits), vceqq_f32(cur, vZero));
+        float32x4_t level = vabsq_f32(cur);
+        if (right) {
+            cur = vld1q_f32(right + i);
+            flip = veorq_s32(vreinterpretq_s32_f32(cur), vreinterpretq_s32_f32(vld1q_f32(right + i - 1)));
+            cross = vandq_u32(cross, vorrq_u32(vcltq_s32(flip, vZeroBits), vceqq_f32(cur, vZero)));
+            level = vmaxq_f32(level, vabsq_f32(cur));
+        }
+        vst1q_f32(cost + i, vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(vaddq_f32(vOne, level)), cross)));
+    }
+#endif
+    for (; i < n; i++) {
+        bool cross = (signbit(left[i]) != signbit(left[i - 1])) || left[i] == 0.0f;
+        float level = fabsf(left[i]);
+        if (right) {
+            cross = cross && ((signbit(right[i]) != signbit(right[i - 1])) || right[i] == 0.0f);
+            level = max(level, fabsf(right[i]));
+        }
+        cost[i] = cross ? 0.0f : 1.0f + level;
+    }
+}
+
+// Keeps the rendered samples of every channel within `radius` frames of
+// each center while the loop is rendered block by block.
+class SampleCapture {
+public:
+    void begin(const vector<int32_t>& centers, int radius, int channels) {
+        mChannels = channels;
+        mSpan = 2 * radius + 1;
+        mFirst.resize(centers.size());
+        for (size_t i = 0; i < centers.size(); i++) mFirst[i] = centers[i] - radius;
+        mSamples.assign(centers.size() * channels * (size_t)mSpan, 0.0f);
+        mCursor = 0;
+    }
+
+    // Takes `frames` rendered frames that start at loop frame blockStart.
+    void feed(float* const* buffers, int blockStart, int frames) {
+        int blockEnd = blockStart + frames;
+        while (mCursor < mFirst.size() && mFirst[mCursor] + mSpan <= blockStart) mCursor++;
+        for (size_t i = mCursor; i < mFirst.size() && mFirst[i] < blockEnd; i++) {
+            int from = max(mFirst[i], blockStart);
+            int to = min(mFirst[i] + mSpan, blockEnd);
+            if (from >= to) continue;
+            for (int c = 0; c < mChannels; c++) {
+                memcpy(samples(i, c) + (from - mFirst[i]), buffers[c] + (from - blockStart),
+                       (size_t)(to - from) * sizeof(float));
+            }
+        }
+    }
+
+    // Channel c around center i; sample 0 is loop frame first(i).
+    float* samples(size_t i, int c) { return &mSamples[(i * mChannels + c) * (size_t)mSpan]; }
+    int first(size_t i) const { return mFirst[i]; }
+    int span() const { return mSpan; }
+    int channels() const { return mChannels; }
+
+private:
+    int mChannels = 0;
+    int mSpan = 0;
+    vector<int32_t> mFirst;
+    vector<float> mSamples;
+    size_t mCursor = 0;
+};
+
+// Snaps starts[i] (loop frames, ascending) using the samples captured
+// around center i. Starts stay in order and inside the loop; a start at
+// or before the loop's first frame stays put. Returns how many moved.
+int snapSliceStarts(SampleCapture& capture, vector<int32_t>& starts, int lengthFrames) {
+    int moved = 0;
+    int previous = 0;
+    vector<float> cost;
+    for (size_t i = 0; i < starts.size(); i++) {
+        int target = starts[i];
+        int from = max(max(target - gSnapFrames, previous + 1), capture.first(i) + 1);
+        int to = min(min(target + gSnapFrames, lengthFrames - 1), capture.first(i) + capture.span() - 1);
+        if (target > 1 && from <= to) {
+            int n = to - from + 1;
+            cost.resize(n);
+            int offset = from - capture.first(i);
+            zeroCrossingCostBlock(capture.samples(i, 0) + offset,
+                                  capture.channels() == 2 ? capture.samples(i, 1) + offset : nullptr, n, cost.data());
+            int best = from;
+            for (int f = from + 1; f <= to; f++) {
+                float c = cost[f - from];
+                float bestCost = cost[best - from];
+                if (c < bestCost || (c == bestCost && abs(f - target) < abs(best - target))) best = f;
+            }
+            if (best != target) moved++;
+            starts[i] = best;
+        }
+        previous = starts[i];
+    }
+    return moved;
+}
+
+// ---------------------------------------------------------------------
+// Silent tails: effective slice and loop lengths, trimmed output
+// ---------------------------------------------------------------------
+// Set from --tails / --trim. A slice's effective length runs from its
+// start to its last frame with any channel above gTailThresholdDb, plus
+// gTailHoldMs so that a release under the threshold isn't cut short. The
+// loop's effective length is measured the same way. With --trim the
+// slice WAVs are written at their effective length, and a loop is
+// compacted: each slice's tail is cut out and the markers close up. Each
+// cut end is faded out over gTailFadeMs.
+bool gTails = false;
+bool gTrim = false;
+double gTailThresholdDb = -60.0;
+double gTailHoldMs = 10.0;
+double gTailFadeMs = 5.0;
+
+int msToFrames(double ms, int sampleRate) {
+    return (int)lround(ms * sampleRate / 1000.0);
+}
+
+// Index of the last frame in [0, n) where any channel's |x| exceeds
+// threshold, or -1. Scans backwards, four frames at a time until a block
+// holds a loud frame. right is null for mono.
+int lastAboveThreshold(const float* left, const float* right, int n, float threshold) {
+    int i = n;
+#if defined(__SSE2__)
+    const __m128 vAbs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 vThreshold = _mm_set1_ps(threshold);
+    for (; i >= 4; i -= 4) {
+        __m128 level = _mm_and_ps(_mm_loadu_ps(left + i - 4), vAbs);
+        if (right) level = _mm_max_ps(level, _mm_and_ps(_mm_loadu_ps(right + i - 4), vAbs));
+        if (_mm_movemask_ps(_mm_cmpgt_ps(level, vThreshold)) != 0) break;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t vThreshold = vdupq_n_f32(threshold);
+    for (; i >= 4; i -= 4) {
+        float32x4_t level = vabsq_f32(vld1q_f32(left + i - 4));
+        if (right) level = vmaxq_f32(level, vabsq_f32(vld1q_f32(right + i - 4)));
+        if (vmaxvq_u32(vcgtq_f32(level, vThreshold)) != 0) break;
+    }
+#endif
+    for (i = i - 1; i >= 0; i--) {
+        float level = fabsf(left[i]);
+        if (right) level = max(level, fabsf(right[i]));
+        if (level > threshold) return i;
+    }
+    return -1;
+}
+
+// Fade-out gain of frame k of an n-frame fade, falling linearly towards 0.
+inline float fadeGain(int k, int n) {
+    return (float)(n - k) / (float)(n + 1);
+}
+
+// Effective length of a span of `frames` frames whose last loud frame is
+// `lastLoud` (relative to its start, -1 for none): never longer than the
+// span, never empty unless the span is.
+int effectiveLength(int lastLoud, int frames, int holdFrames) {
+    int length = min(frames, max(lastLoud + 1, 0) + holdFrames);
+    return (frames > 0) ? max(length, 1) : 0;
+}
+
+// Finds the last loud frame before any slice end of a loop rendered
+// block by block. Like the level meter, it keeps the envelope per frame
+// only within `radius` of each center (where slice starts, and so the
+// previous slice's end, may land), together with the last loud frame
+// before each of those windows.
+class TailTracker {
+public:
+    void begin(const vector<int32_t>& centers, int radius, float threshold) {
+        mThreshold = threshold;
+        mSpan = 2 * radius + 1;
+        mFirst.resize(centers.size());
+        for (size_t i = 0; i < centers.size(); i++) mFirst[i] = centers[i] - radius;
+        mLastBefore.assign(centers.size(), -1);
+        mEnvelope.assign(centers.size() * (size_t)mSpan, 0.0f);
+        mLast = -1;
+        mFed = 0;
+        mCursor = 0;
+    }
+
+    // Takes `frames` rendered frames that start at loop frame blockStart.
+    void feed(float* const* buffers, int channels, int blockStart, int frames) {
+        const float* right = (channels == 2) ? buffers[1] : nullptr;
+        int blockEnd = blockStart + frames;
+        while (mCursor < mFirst.size() && mFirst[mCursor] + mSpan <= blockStart) mCursor++;
+        for (size_t i = mCursor; i < mFirst.size() && mFirst[i] < blockEnd; i++) {
+            if (mFirst[i] >= blockStart) {
+                int found = lastAboveThreshold(buffers[0], right, mFirst[i] - blockStart, mThreshold);
+                mLastBefore[i] = (found >= 0) ? blockStart + found : mLast;
+            }
+            int from = max(mFirst[i], blockStart);
+            int to = min(mFirst[i] + mSpan, blockEnd);
+            float* envelope = &mEnvelope[i * (size_t)mSpan];
+            for (int f = from; f < to; f++) {
+                float level = fabsf(buffers[0][f - blockStart]);
+                if (right) level = max(level, fabsf(right[f - blockStart]));
+                envelope[f - mFirst[i]] = level;
+            }
+        }
+        int found = lastAboveThreshold(buffers[0], right, frames, mThreshold);
+        if (found >= 0) mLast = blockStart + found;
+        mFed = blockEnd;
+    }
+
+    // Last loud frame before loop frame `end`, or -1. `end` must be the
+    // end of everything fed or lie within a window.
+    int lastLoudBefore(int end) const {
+        if (end >= mFed) return mLast;
+        for (size_t i = 0; i < mFirst.size(); i++) {
+            if (mFirst[i] <= end && end <= mFirst[i] + mSpan) {
+                int found = lastAboveThreshold(&mEnvelope[i * (size_t)mSpan], nullptr, end - mFirst[i], mThreshold);
+                return (found >= 0) ? mFirst[i] + found : mLastBefore[i];
+            }
+        }
+        return -1;
+    }
+
+private:
+    float mThreshold = 0.0f;
+    int mSpan = 0;
+    vector<int32_t> mFirst;
+    vector<int32_t> mLastBefore;
+    vector<float> mEnvelope;
+    int mLast = -1;
+    int mFed = 0;
+    size_t mCursor = 0;
+};
+
+// What previewRenderFullLoop (or renderSlices) produced, for the txt and
+// metadata writers. In slice mode sliceFiles holds the per-slice WAVs.
+// latency is the per-file compensation applied to the markers, tempo the
+// preview tempo the loop was rendered at. With --analyze the levels of the
+// rendered audio (before any --trim) are in levels and sliceLevels. With
+// --tails effectiveLength is the loop's length without its silent tail;
+// -1 when not measured, and in slice mode.
+struct RenderedLoop {
+    int lengthFrames = 0;
+    int latency = 0;
+    int tempo = 0;
+    SampleFormat format = kFormatS16;
+    SliceTable slices;
+    vector<string> sliceFiles;
+    bool analyzed = false;
+    LevelStats levels;
+    vector<LevelStats> sliceLevels;
+    int effectiveLength = -1;
+};
+
+// Fades the n PCM frames at `data` (as written in `format`), frames
+// first.. of a fadeFrames-long fade, out with the fadeGain ramp. Integer
+// samples are rounded back without dither.
+void fadeOutPcm(unsigned char* data, int first, int n, int fadeFrames, int channels, SampleFormat format) {
+    int bytes = sampleFormatBytes(format);
+    for (int k = 0; k < n; k++) {
+        float gain = fadeGain(first + k, fadeFrames);
+        for (int c = 0; c < channels; c++) {
+            unsigned char* s = data + ((size_t)k * channels + c) * bytes;
+            if (format == kFormatF32) {
+                float v;
+                memcpy(&v, s, sizeof(v));
+                v *= gain;
+                memcpy(s, &v, sizeof(v));
+            } else if (format == kFormatS24) {
+                int32_t v = (int32_t)((uint32_t)s[0] << 8 | (uint32_t)s[1] << 16 | (uint32_t)s[2] << 24) >> 8;
+                v = (int32_t)lrintf(v * gain);
+                s[0] = (unsigned char)(v & 0xFF);
+                s[1] = (unsigned char)((v >> 8) & 0xFF);
+                s[2] = (unsigned char)((v >> 16) & 0xFF);
+            } else {
+                int16_t v = (int16_t)(s[0] | (s[1] << 8));
+                v = (int16_t)lrintf(v * gain);
+                s[0] = (unsigned char)(v & 0xFF);
+                s[1] = (unsigned char)((v >> 8) & 0xFF);
+            }
+        }
+    }
+}
+
+// The same fade on planar float frames [offset, offset + frames).
+void fadeOutBlock(float* const* buffers, int channels, int offset, int frames) {
+    for (int c = 0; c < channels; c++) {
+        for (int k = 0; k < frames; k++) buffers[c][offset + k] *= fadeGain(k, frames);
+    }
+}
+
+// --trim for a loop: compacts the finished loop WAV in place, every
+// slice cut to its effective length and faded out where it was cut.
+// Frames before the first slice are kept. Kept frames only ever move
+// towards the start of the file, so they are copied as written a block
+// at a time (frames that stay put are left alone), then the file is cut
+// to the new length and its header patched. starts holds the slices'
+// unclamped starts; they, the slice frames, originalStart and the loop's
+// lengths move to the compacted positions.
+bool compactLoopWav(const string& path, RenderedLoop& loop, vector<int32_t>& starts,
+                    int channels, int sampleRate, int fadeFrames) {
+    size_t frameBytes = (size_t)channels * sampleFormatBytes(loop.format);
+    int length = loop.lengthFrames;
+    FILE* file = fopen(path.c_str(), "r+b");
+    if (file == nullptr) return false;
+
+    vector<unsigned char> block((size_t)kConvertBlockFrames * frameBytes);
+    int compacted = 0; // frames of the result so far
+    bool ok = true;
+    auto keepFrames = [&](int from, int keep, int start, int end) {
+        int fade = (keep < end) ? min(fadeFrames, keep - start) : 0;
+        int fadeStart = keep - fade;
+        for (int pos = from; ok && pos < keep; ) {
+            int todo = min(kConvertBlockFrames, keep - pos);
+            bool fades = pos + todo > fadeStart;
+            if (compacted != pos || fades) {
+                size_t bytes = (size_t)todo * frameBytes;
+                ok = fseek(file, (long)(44 + (size_t)pos * frameBytes), SEEK_SET) == 0
+                  && fread(block.data(), 1, bytes, file) == bytes;
+                if (ok && fades) {
+                    int first = max(pos, fadeStart);
+                    fadeOutPcm(block.data() + (size_t)(first - pos) * frameBytes, first - fadeStart,
+                               pos + todo - first, fade, channels, loop.format);
+                }
+                ok = ok && fseek(file, (long)(44 + (size_t)compacted * frameBytes), SEEK_SET) == 0
+                        && fwrite(block.data(), 1, bytes, file) == bytes;
+            }
+            pos += todo;
+            compacted += todo;
+        }
+    };
+
+    SliceTable& slices = loop.slices;
+    if (slices.empty()) keepFrames(0, loop.effectiveLength, 0, length);
+    for (size_t i = 0; ok && i < slices.size(); i++) {
+        int start = min(max(starts[i], 0), length);
+        int end = min(max(slices.frameEnd[i], start), length);
+        int from = (i == 0) ? 0 : start;
+        int shift = compacted - from;
+        keepFrames(from, min(start + slices.effectiveLength[i], end), start, end);
+        starts[i] += shift;
+        slices.frameStart[i] = starts[i];
+        if (i < slices.originalStart.size()) slices.originalStart[i] += shift;
+    }
+    loop.lengthFrames = compacted;
+    loop.effectiveLength = compacted;
+    finishLoopSliceFrames(slices, compacted);
+
+    unsigned char header[44];
+    buildWavHeader(header, compacted, channels, loop.format, sampleRate);
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    ok = (fclose(file) == 0) && ok;
+    uint64_t size = sizeof(header) + (uint64_t)compacted * frameBytes;
+    error_code ec;
+    if (ok) std::filesystem::resize_file(path, size, ec);
+    statsAdd(&JobStats::outputBytes, size);
+    return ok && !ec;
+}
+
+// The txt output: one Renoise insert_slice_marker command per slice, or
+// in slice mode one slice WAV path per line.
+string sliceText(const RenderedLoop& loop) {
+    ostringstream txt;
+    if (!loop.sliceFiles.empty()) {
+        for (const string& sliceFile : loop.sliceFiles) txt << sliceFile << "\n";
+    } else {
+        for (int32_t frameStart : loop.slices.frameStart) {
+            txt << "renoise.song().selected_sample:insert_slice_marker(" << frameStart << ")\n";
+        }
+    }
+    return txt.str();
+}
+
+bool writeSliceText(const string& txtPath, const RenderedLoop& loop) {
+    ofstream txtFile(txtPath);
+    if (!txtFile) return false;
+    string txt = sliceText(loop);
+    txtFile << txt;
+    statsAdd(&JobStats::outputBytes, txt.size());
+    return (bool)txtFile;
+}
+
+// ---------------------------------------------------------------------
+// Stream output: the whole decode as one framed byte stream
+// ---------------------------------------------------------------------
+// Set from --stream. Instead of output files, a single decode is written
+// to stdout or to a POSIX shared memory segment as:
+//   char[4]  magic "RX2S"
+//   uint32   version (1)
+// followed by chunks of
+//   char[4]  tag
+//   uint32   payload size
+//   payload
+// in this order: "WAVE" (the complete WAV file), "TEXT" (what the txt
+// output would hold), "META" (metadata in --meta-format) and "END "
+// (empty). Integers are little-endian. A stream that stops before END
+// belongs to a failed decode.
+enum StreamTarget { kStreamNone, kStreamStdout, kStreamShm };
+StreamTarget gStreamTarget = kStreamNone;
+string gStreamShmName;  // "/name" for kStreamShm
+
+const uint32_t kStreamVersion = 1;
+
+bool writeStreamChunkHeader(FILE* stream, const char tag[4], uint32_t size) {
+    unsigned char header[8];
+    memcpy(header, tag, 4);
+    putLE32(header + 4, size);
+    return fwrite(header, 1, sizeof(header), stream) == sizeof(header);
+}
+
+bool writeStreamChunk(FILE* stream, const char tag[4], const string& payload) {
+    statsAdd(&JobStats::outputBytes, payload.size());
+    return writeStreamChunkHeader(stream, tag, (uint32_t)payload.size())
+        && fwrite(payload.data(), 1, payload.size(), stream) == payload.size();
+}
+
+// Render resources shared by all tempo variants of one job: the block
+// buffer and the streaming writer (with its conversion buffers) are
+// allocated for the first variant and reused by the others.
+struct PreviewPool {
+    vector<float> blockSamples;
+    StreamingWavWriter writer;
+    LevelMeter meter;
+    vector<unsigned char> renderBytes;
+};
+
+// The second pass of --normalize: reads back the float WAV `render` of
+// `frames` frames, scales it by `gain` and hands it to `writer` block by
+// block, through `buffers` (kRenderBlockFrames frames per channel).
+bool writeScaledRender(FILE* render, int frames, int channels, float gain, float* const* buffers,
+                       vector<unsigned char>& bytes, StreamingWavWriter& writer) {
+    bytes.resize((size_t)kRenderBlockFrames * channels * 4);
+    bool ok = fseek(render, 44, SEEK_SET) == 0;
+    for (int done = 0; ok && done < frames; ) {
+        int todo = min(kRenderBlockFrames, frames - done);
+        size_t size = (size_t)todo * channels * 4;
+        ok = fread(bytes.data(), 1, size, render) == size;
+        for (int f = 0; ok && f < todo; f++) {
+            for (int c = 0; c < channels; c++) {
+                const unsigned char* in = &bytes[((size_t)f * channels + c) * 4];
+                uint32_t bits = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                buffers[c][f] = value * gain;
+            }
+        }
+        ok = ok && writer.write(buffers, todo);
+        done += todo;
+    }
+    return ok;
+}
+
+// Preview render function like REX Test App, at preview tempo `tempo`.
+// loop.slices must hold the handle's slice table (fetchSliceTable); its
+// frame columns are filled in. With `stream` set the WAV goes there as a
+// WAVE chunk (wavPath only names it in the log) and no txt is written.
+REX::REXError previewRenderFullLoop(REX::REXHandle handle, const string& wavPath, const string& txtPath, ostream& log,
+                                    RenderedLoop& loop, int tempo, PreviewPool& pool, FILE* stream = nullptr) {
+    REX::REXError result;
+    REX::REXInfo info;
+    vector<float>& blockSamples = pool.blockSamples;
+    float* renderBuffers[2] = {nullptr, nullptr};
+    int lengthFrames = 0;
+    int framesRendered = 0;
+
+    result = sdkCall(REX::REXGetInfo, handle, sizeof(REX::REXInfo), &info);
+    if (result != REX::kREXError_NoError) {
+        return result;
+    }
+    // Whatever rate the backend reports after REXSetOutputSampleRate, the
+    // render, WAV header and markers all use the requested output rate
+    int sampleRate = outputSampleRate(info);
+
+    // Calculate length in frames of preview rendered loop (same formula as REX Test App)
+    lengthFrames = previewLengthFrames(info, tempo);
+    loop.lengthFrames = lengthFrames;
+    loop.tempo = tempo;
+    statsAdd(&JobStats::sdkCalls, 4); // REXGetInfo, REXSetPreviewTempo, REXStartPreview, REXStopPreview
+
+    if (logDebug()) {
+        log << "=== LENGTH CALCULATION DEBUG ===\n";
+        log << "REX Test App formula: (sampleRate * 1000.0 * PPQLength) / (tempo * 256)\n";
+        log << "Step by step:\n";
+        log << "  Sample Rate: " << sampleRate << "\n";
+        log << "  PPQ Length: " << info.fPPQLength << "\n";
+        log << "  Tempo: " << tempo << " (internal units)\n";
+        log << "  Real BPM: " << (tempo / 1000.0) << "\n";
+        log << "  Calculation: (" << sampleRate << " * 1000.0 * " << info.fPPQLength << ") / (" << tempo << " * 256)\n";
+        log << "  = " << (sampleRate * 1000.0 * info.fPPQLength) << " / " << (tempo * 256) << "\n";
+        double exactLength = previewLengthExact(info, tempo);
+        log << "  = " << exactLength << " (exact)\n";
+        log << "  = " << lengthFrames << " frames (after rounding)\n";
+        log << "  Precision difference: " << (exactLength - lengthFrames) << " frames\n";
+        log << "=================================\n";
+
+        log << "Calculated preview length: " << lengthFrames << " frames\n";
+    }
+
+    // One fixed-size block for all channels, reused for the whole loop
+    blockSamples.resize((size_t)info.fChannels * kRenderBlockFrames);
+    renderBuffers[0] = blockSamples.data();
+    if (info.fChannels == 2) {
+        renderBuffers[1] = blockSamples.data() + kRenderBlockFrames;
+    } else {
+        renderBuffers[1] = nullptr;
+    }
+
+    // Set preview tempo (the file's own tempo unless --tempo is given)
+    result = sdkCall(REX::REXSetPreviewTempo, handle, tempo);
+    if(result != REX::kREXError_NoError) {
+        cerr << "REXSetPreviewTempo failed: " << result << endl;
+        return result;
+    }
+
+    // --normalize: the render goes to a float temp file, metered on the
+    // way, and is scaled into the output once its level is known
+    LevelMeter& meter = pool.meter;
+    int renderCalls = 0;
+    double gain = 0.0;
+    bool normalize = (gNormalizeMode != kNormalizeNone);
+    loop.format = resolveSampleFormat(info);
+    StreamingWavWriter& writer = pool.writer;
+    auto openOutput = [&]() {
+        bool opened;
+        if (stream) {
+            uint32_t wavBytes = 44 + (uint32_t)lengthFrames * info.fChannels * sampleFormatBytes(loop.format);
+            opened = writeStreamChunkHeader(stream, "WAVE", wavBytes)
+                  && writer.openStream(stream, info.fChannels, loop.format, sampleRate, lengthFrames);
+        } else {
+            opened = writer.open(wavPath, info.fChannels, loop.format, sampleRate);
+        }
+        if (!opened) cerr << "Failed to open output WAV file: " << wavPath << endl;
+        return opened;
+    };
+    unique_ptr<FILE, int (*)(FILE*)> renderFile(nullptr, fclose);
+    if (normalize) {
+        renderFile.reset(tmpfile());
+        if (!renderFile || !writer.openStream(renderFile.get(), info.fChannels, kFormatF32, sampleRate, lengthFrames)) {
+            cerr << "Failed to open a temp file for the normalize pass" << endl;
+            return REX::kREXError_Undefined;
+        }
+    } else if (!openOutput()) {
+        return REX::kREXError_Undefined;
+    }
+
+    // Start preview
+    StageTimer renderTimer("render");
+    result = sdkCall(REX::REXStartPreview, handle);
+    if(result != REX::kREXError_NoError) {
+        cerr << "REXStartPreview failed: " << result << endl;
+        writer.finish();
+        if (!stream) remove(wavPath.c_str());
+        return result;
+    }
+
+    // PPQ-derived slice frames; with a measured latency the audio around
+    // each of them is captured during the render
+    SliceTable& slices = loop.slices;
+    vector<int32_t> rawFrames(slices.size());
+    for (size_t i = 0; i < slices.size(); i++) {
+        rawFrames[i] = ppqToFrame(slices.ppqPos[i], info.fPPQLength, lengthFrames);
+    }
+    OnsetCapture onsets;
+    if (gLatencyMode != kLatencyFixed) onsets.begin(rawFrames);
+    // Slices start at their PPQ frame plus the latency, then maybe snapped.
+    // A measured latency is only known after the render, so the meter and
+    // the snap capture keep every frame a start could move to.
+    bool fixedLatency = (gLatencyMode == kLatencyFixed);
+    vector<int32_t> centers(rawFrames);
+    if (fixedLatency) for (int32_t& center : centers) center += gLatencyFrames;
+    int radius = (fixedLatency ? 0 : max(kOnsetSearchFrames, abs(gLatencyFrames)))
+               + (gSnapZeroCrossing ? gSnapFrames : 0);
+    if (gAnalyze) meter.begin(sampleRate, info.fChannels, lengthFrames, centers, radius);
+    SampleCapture crossings;
+    if (gSnapZeroCrossing) crossings.begin(centers, radius + 1, info.fChannels);
+    TailTracker tails;
+    if (gTails) tails.begin(centers, radius, (float)pow(10.0, gTailThresholdDb / 20.0));
+
+    // Render block by block, each block in REXRenderPreviewBatch calls of
+    // gRenderBatchFrames, and hand every finished block to the writer
+    while (framesRendered != lengthFrames) {
+        int blockFrames = min(kRenderBlockFrames, lengthFrames - framesRendered);
+        result = renderPreviewFrames(handle, renderBuffers, 0, blockFrames, gRenderBatchFrames, &renderCalls);
+        if(result != REX::kREXError_NoError) {
+            cerr << "REXRenderPreviewBatch failed: " << result << endl;
+            sdkCall(REX::REXStopPreview, handle);
+            writer.finish();
+            if (!stream) remove(wavPath.c_str());
+            return result;
+        }
+
+        if (gAnalyze) meter.feed(renderBuffers, blockFrames);
+        if (!writer.write(renderBuffers, blockFrames)) {
+            cerr << "Failed to write output WAV file: " << wavPath << endl;
+            sdkCall(REX::REXStopPreview, handle);
+            writer.finish();
+            if (!stream) remove(wavPath.c_str());
+            return REX::kREXError_Undefined;
+        }
+        if (gLatencyMode != kLatencyFixed) onsets.feed(renderBuffers, framesRendered, blockFrames);
+        if (gSnapZeroCrossing) crossings.feed(renderBuffers, framesRendered, blockFrames);
+        if (gTails) tails.feed(renderBuffers, info.fChannels, framesRendered, blockFrames);
+        framesRendered += blockFrames;
+    }
+    
+    // Stop preview
+    result = sdkCall(REX::REXStopPreview, handle);
+    renderTimer.stop();
+    statsAdd(&JobStats::sdkCalls, renderCalls);
+    statsAdd(&JobStats::renderCalls, renderCalls);
+    statsAdd(&JobStats::frames, lengthFrames);
+    if(result != REX::kREXError_NoError) {
+        cerr << "REXStopPreview failed: " << result << endl;
+        writer.finish();
+        if (!stream) remove(wavPath.c_str());
+        return result;
+    }
+
+    if (logDebug()) log << "Render batch size: " << gRenderBatchFrames << " frames\n";
+    StageTimer writeTimer("write");
+    bool finished = writer.finish();
+    if (gAnalyze) meter.finish();
+    if (normalize && finished) {
+        gain = normalizeGain(levelStats(meter.total(), info.fChannels, meter.integratedLoudness()));
+        if (logSummary()) log << "Normalize gain: " << fixed << setprecision(2) << gain << " dB\n";
+        finished = openOutput();
+        if (finished) {
+            finished = writeScaledRender(renderFile.get(), lengthFrames, info.fChannels, (float)pow(10.0, gain / 20.0),
+                                         renderBuffers, pool.renderBytes, writer);
+            finished = writer.finish() && finished;
+        }
+    }
+    renderFile.reset();
+    writeTimer.stop();
+    if (finished) {
+        statsAdd(&JobStats::outputBytes, 44 + (uint64_t)lengthFrames * info.fChannels * sampleFormatBytes(loop.format));
+        if (logSummary()) log << "Full loop written to: " << wavPath << " (" << sampleFormatName(loop.format) << ")\n";
+    } else {
+        cerr << "Failed to write output WAV file: " << wavPath << endl;
+        if (!stream) remove(wavPath.c_str());
+        return REX::kREXError_Undefined;
+    }
+
+    // Calculate slice markers for Renoise and write txt file
+    // Use the actual rendered length, not a separate calculation
+    if (logDebug()) {
+        log << "=== COMPREHENSIVE SLICE DEBUG ANALYSIS ===\n";
+        log << "Original file info:\n";
+        log << "  Sample Rate: " << sampleRate << " Hz\n";
+        log << "  Tempo: " << info.fTempo << " (Real BPM: " << (info.fTempo / 1000.0) << ")\n";
+        log << "  Render Tempo: " << tempo << " (Real BPM: " << (tempo / 1000.0) << ")\n";
+        log << "  PPQ Length: " << info.fPPQLength << " PPQ units\n";
+        log << "  Total Slices: " << info.fSliceCount << "\n";
+        log << "\n";
+    
+        log << "Rendered preview info:\n";
+        log << "  Total rendered frames: " << lengthFrames << "\n";
+        log << "  Rendered duration: " << (double)lengthFrames / sampleRate << " seconds\n";
+        log << "  Frames per PPQ unit: " << (double)lengthFrames / info.fPPQLength << "\n";
+        log << "\n";
+    
+        log << "=== DETAILED SLICE ANALYSIS ===\n";
+    }
+    vector<int32_t> latency;
+    int detected = 0;
+    loop.latency = resolveSliceLatency(onsets, rawFrames, latency, detected);
+    if (gLatencyMode != kLatencyFixed && logSummary()) {
+        log << "Measured preview latency: " << loop.latency << " frames (onsets found for "
+            << detected << "/" << slices.size() << " slices"
+            << (detected == 0 ? ", using the default" : "") << ")\n";
+    }
+    computeLoopSliceFrames(slices, info.fPPQLength, lengthFrames, latency);
+    vector<int32_t> starts(slices.size());
+    for (size_t i = 0; i < slices.size(); i++) starts[i] = rawFrames[i] + latency[i];
+    if (gSnapZeroCrossing) {
+        slices.originalStart = slices.frameStart;
+        int moved = snapSliceStarts(crossings, starts, lengthFrames);
+        copy(starts.begin(), starts.end(), slices.frameStart.begin());
+        finishLoopSliceFrames(slices, lengthFrames);
+        if (logSummary()) {
+            log << "Snapped " << moved << "/" << slices.size() << " slice markers to zero crossings (window "
+                << gSnapFrames << " frames)\n";
+        }
+    }
+    if (gAnalyze) {
+        // Metered before the gain, which shifts every level by itself
+        loop.analyzed = true;
+        loop.levels = levelStats(meter.total(), info.fChannels, meter.integratedLoudness());
+        applyGain(loop.levels, gain);
+        loop.sliceLevels.resize(slices.size());
+        for (size_t i = 0; i < slices.size(); i++) {
+            LevelSums sums = meter.range(starts[i], slices.frameEnd[i]);
+            loop.sliceLevels[i] = levelStats(sums, info.fChannels, rangeLoudness(sums));
+            applyGain(loop.sliceLevels[i], gain);
+        }
+        if (logSummary()) {
+            log << "Loop levels: peak " << fixed << setprecision(2) << loop.levels.peak
+                << " dBFS, true peak " << loop.levels.truePeak << " dBTP, RMS " << loop.levels.rms
+                << " dBFS, loudness " << loop.levels.loudness << " LUFS\n";
+        }
+    }
+    for (size_t i = 0; logDebug() && i < slices.size(); i++) {
+        double ratio = (double)slices.ppqPos[i] / (double)info.fPPQLength;
+        int rawFramePosition = rawFrames[i];
+        int framePosition = slices.frameStart[i];
+        int nextSliceStart = slices.frameEnd[i];
+        int sliceLength = nextSliceStart - framePosition;
+
+        // Time calculations
+        double sliceStartTime = (double)framePosition / sampleRate;
+        double sliceEndTime = (double)nextSliceStart / sampleRate;
+        double sliceDuration = sliceEndTime - sliceStartTime;
+
+        log << "Slice " << setfill('0') << setw(3) << (i+1) << setfill(' ') << ":\n";
+        log << "  PPQ Position: " << slices.ppqPos[i] << " / " << info.fPPQLength;
+        log << " (ratio: " << fixed << setprecision(6) << ratio << ")\n";
+        log << "  Original Sample Length: " << slices.sampleLength[i] << " samples\n";
+        log << "  Raw Frame Position: " << rawFramePosition << "\n";
+        log << "  Latency Compensation: " << latency[i] << " frames\n";
+        if (i < slices.originalStart.size()) {
+            log << "  Zero-crossing snap: " << slices.originalStart[i] << " -> " << framePosition << "\n";
+        }
+        log << "  Final Frame Start: " << framePosition << "\n";
+        log << "  Rendered Frame End: " << nextSliceStart << "\n";
+        log << "  Rendered Slice Length: " << sliceLength << " frames\n";
+        log << "  Time Start: " << fixed << setprecision(6) << sliceStartTime << "s\n";
+        log << "  Time End: " << fixed << setprecision(6) << sliceEndTime << "s\n";
+        log << "  Time Duration: " << fixed << setprecision(6) << sliceDuration << "s\n";
+
+        // Show the math step by step
+        log << "  Math: " << slices.ppqPos[i] << " / " << info.fPPQLength << " * " << lengthFrames;
+        log << " = " << ratio << " * " << lengthFrames << " = " << (ratio * lengthFrames);
+        log << " → " << rawFramePosition << " + (" << latency[i] << ") = " << framePosition << "\n";
+
+        log << "  Renoise command: renoise.song().selected_sample:insert_slice_marker(" << framePosition << ")\n";
+        log << "\n";
+    }
+    
+    if (logDebug()) {
+        log << "=== SUMMARY ===\n";
+        log << "Applied latency compensation: " << loop.latency << " frames ("
+            << latencyModeName(gLatencyMode) << ")\n";
+        log << "Total analysis complete. Check frame positions against actual audio transients.\n";
+        log << "If positions are still off:\n";
+        log << "  - Try --latency auto (measured per file) or auto-slice (per slice)\n";
+        log << "  - Or pass --latency N (currently " << gLatencyFrames << " frames by default)\n";
+        log << "  - Positive values shift markers later in time\n";
+        log << "  - Negative values shift markers earlier in time\n";
+        log << "  - Each frame = " << fixed << setprecision(3) << (1000.0 / sampleRate) << "ms at " << sampleRate << "Hz\n";
+        log << "=============================================\n";
+    }
+
+    // Effective lengths; --trim then compacts the loop to them
+    if (gTails) {
+        int holdFrames = msToFrames(gTailHoldMs, sampleRate);
+        loop.effectiveLength = effectiveLength(tails.lastLoudBefore(lengthFrames), lengthFrames, holdFrames);
+        slices.effectiveLength.resize(slices.size());
+        for (size_t i = 0; i < slices.size(); i++) {
+            int start = min(max(starts[i], 0), lengthFrames);
+            int end = min(max(slices.frameEnd[i], start), lengthFrames);
+            slices.effectiveLength[i] = effectiveLength(tails.lastLoudBefore(end) - start, end - start, holdFrames);
+        }
+        if (logSummary()) log << "Effective loop length: " << loop.effectiveLength << " of " << lengthFrames << " frames\n";
+        if (gTrim && !stream) {
+            StageTimer trimTimer("trim");
+            if (!compactLoopWav(wavPath, loop, starts, info.fChannels, sampleRate,
+                                msToFrames(gTailFadeMs, sampleRate))) {
+                cerr << "Failed to compact output WAV file: " << wavPath << endl;
+                remove(wavPath.c_str());
+                return REX::kREXError_Undefined;
+            }
+            if (logSummary()) log << "Compacted loop: " << loop.lengthFrames << " frames\n";
+        }
+    }
+
+    // Write text file with Renoise commands
+    StageTimer textTimer("text");
+    if (stream) {
+        // the caller adds the TEXT chunk
+    } else if (writeSliceText(txtPath, loop)) {
+        if (logSummary()) log << "Renoise slice commands written to: " << txtPath << "\n";
+    } else {
+        cerr << "Failed to open output text file: " << txtPath << endl;
+    }
+
+    return REX::kREXError_NoError;
+}
+
+// ---------------------------------------------------------------------
+// Per-slice render: one WAV per slice via REXRenderSlice
+// ---------------------------------------------------------------------
+// Set from --slices / --jobs. Slice mode replaces the full-loop preview
+// render; the slice WAVs are written by gSliceWriters threads.
+bool gSliceMode = false;
+int gSliceWriters = 1;
+
+// output.wav -> output_001.wav, output_002.wav, ...
+string sliceWavPath(const string& wavPath, int sliceIndex) {
+    ostringstream name;
+    name << splitExtension(wavPath).first
+         << "_" << setfill('0') << setw(3) << (sliceIndex + 1) << ".wav";
+    return name.str();
+}
+
+// Renders every slice natively into one shared arena (channel-planar per
+// slice, slices back to back), then writes the slice WAVs in parallel.
+// The SDK calls stay on this thread (sdkCall runs them one at a time
+// anyway); only the conversion/file writes are spread out. The txt
+// output lists one slice WAV path per line. loop.slices must hold the
+// handle's slice table (fetchSliceTable).
+REX::REXError renderSlices(REX::REXHandle handle, const string& wavPath, const string& txtPath, ostream& log, RenderedLoop& loop) {
+    REX::REXInfo info;
+    REX::REXError result = sdkCall(REX::REXGetInfo, handle, sizeof(REX::REXInfo), &info);
+    if (result != REX::kREXError_NoError) {
+        return result;
+    }
+    int sampleRate = outputSampleRate(info);
+
+    SliceTable& slices = loop.slices;
+    computeConcatenatedSliceFrames(slices);
+    loop.sliceFiles.clear();
+    for (size_t i = 0; i < slices.size(); i++) loop.sliceFiles.push_back(sliceWavPath(wavPath, (int)i));
+    size_t arenaFrames = slices.empty() ? 0 : (size_t)slices.frameEnd.back();
+    loop.lengthFrames = (int)arenaFrames;
+    loop.tempo = info.fTempo; // slices play at the file's own timing
+    loop.format = resolveSampleFormat(info);
+
+    vector<float> arena;
+    try {
+        arena.resize(arenaFrames * info.fChannels);
+    } catch (const bad_alloc&) {
+        cerr << "Allocation failed for slice render arena" << endl;
+        return REX::kREXError_OutOfMemory;
+    }
+
+    // Per-slice channel pointers into the arena
+    vector<float*> channelBuffers(slices.size() * 2, nullptr);
+    statsAdd(&JobStats::sdkCalls, 1 + slices.size());
+    statsAdd(&JobStats::renderCalls, slices.size());
+    statsAdd(&JobStats::frames, arenaFrames);
+    {
+        StageTimer renderTimer("render");
+        for (size_t i = 0; i < slices.size(); i++) {
+            float* base = arena.data() + (size_t)slices.frameStart[i] * info.fChannels;
+            channelBuffers[i * 2] = base;
+            channelBuffers[i * 2 + 1] = (info.fChannels == 2) ? base + slices.sampleLength[i] : nullptr;
+            result = sdkCall(REX::REXRenderSlice, handle, (int)i, slices.sampleLength[i], &channelBuffers[i * 2]);
+            if (result != REX::kREXError_NoError) {
+                cerr << "REXRenderSlice failed for slice " << (i + 1) << ": " << result << endl;
+                return result;
+            }
+        }
+    }
+
+    // Each slice is metered (and normalized) on its own
+    if (gAnalyze) {
+        StageTimer analyzeTimer("analyze");
+        LevelMeter meter;
+        loop.analyzed = true;
+        loop.sliceLevels.resize(slices.size());
+        for (size_t i = 0; i < slices.size(); i++) {
+            int frames = slices.sampleLength[i];
+            meter.begin(sampleRate, info.fChannels, frames, vector<int32_t>(), 0);
+            meter.feed(&channelBuffers[i * 2], frames);
+            meter.finish();
+            LevelStats& stats = loop.sliceLevels[i];
+            stats = levelStats(meter.total(), info.fChannels, rangeLoudness(meter.total()));
+            double gain = normalizeGain(stats);
+            if (gain != 0.0) {
+                scaleBlock(&channelBuffers[i * 2], info.fChannels, frames, (float)pow(10.0, gain / 20.0));
+                applyGain(stats, gain);
+            }
+        }
+    }
+
+    // Effective lengths; with --trim the slices are cut (and faded) to them
+    if (gTails) {
+        int holdFrames = msToFrames(gTailHoldMs, sampleRate);
+        int fadeFrames = msToFrames(gTailFadeMs, sampleRate);
+        float threshold = (float)pow(10.0, gTailThresholdDb / 20.0);
+        slices.effectiveLength.resize(slices.size());
+        for (size_t i = 0; i < slices.size(); i++) {
+            int frames = slices.sampleLength[i];
+            int last = lastAboveThreshold(channelBuffers[i * 2], channelBuffers[i * 2 + 1], frames, threshold);
+            int length = effectiveLength(last, frames, holdFrames);
+            slices.effectiveLength[i] = length;
+            if (gTrim && length < frames) {
+                int fade = min(fadeFrames, length);
+                fadeOutBlock(&channelBuffers[i * 2], info.fChannels, length - fade, fade);
+            }
+        }
+    }
+
+    atomic<size_t> nextSlice(0);
+    atomic<int> writeFailures(0);
+    auto writeWorker = [&]() {
+        for (;;) {
+            size_t i = nextSlice++;
+            if (i >= slices.size()) break;
+            int frames = gTrim ? slices.effectiveLength[i] : slices.sampleLength[i];
+            if (!writeWavFile(loop.sliceFiles[i], frames, info.fChannels, loop.format,
+                              sampleRate, &channelBuffers[i * 2])) {
+                cerr << "Failed to write slice WAV file: " << loop.sliceFiles[i] << endl;
+                writeFailures++;
+            }
+        }
+    };
+    int writerCount = min(gSliceWriters, (int)slices.size());
+    vector<thread> writers;
+    {
+        StageTimer writeTimer("write");
+        for (int w = 1; w < writerCount; w++) writers.emplace_back(writeWorker);
+        writeWorker();
+        for (thread& writer : writers) writer.join();
+    }
+    if (writeFailures > 0) {
+        return REX::kREXError_Undefined;
+    }
+    size_t writtenFrames = 0;
+    for (size_t i = 0; i < slices.size(); i++) writtenFrames += gTrim ? slices.effectiveLength[i] : slices.sampleLength[i];
+    statsAdd(&JobStats::outputBytes, slices.size() * 44 + writtenFrames * info.fChannels * sampleFormatBytes(loop.format));
+    if (logSummary()) log << slices.size() << " slice WAVs written next to: " << wavPath << "\n";
+
+    StageTimer textTimer("text");
+    if (!writeSliceText(txtPath, loop)) {
+        cerr << "Failed to open output text file: " << txtPath << endl;
+    }
+    return REX::kREXError_NoError;
+}
+
+// Read-only input file view: mmap() / file mapping with a plain read fallback
+// ---------------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { release(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& path) {
+        release();
+#if defined(_WIN32)
+        wstring pathW = ConvertToWide(path.c_str());
+        HANDLE file = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            return false;
+        }
+        mSize = (size_t)fileSize.QuadPart;
+        if (mSize > 0) {
+            HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping != NULL) {
+                void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                // The view keeps the mapping alive on its own
+                CloseHandle(mapping);
+                if (view != NULL) {
+                    mData = (const char*)view;
+                    mMapped = true;
+                }
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        mSize = (size_t)st.st_size;
+        if (mSize > 0) {
+            void* view = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                madvise(view, mSize, MADV_SEQUENTIAL);
+                mData = (const char*)view;
+                mMapped = true;
+            }
+        }
+        ::close(fd);
+#endif
+        return mMapped || readFallback(path);
+    }
+
+    // Unmaps (or frees) the file as soon as the caller is done with it.
+    void release() {
+        if (mMapped) {
+#if defined(_WIN32)
+            UnmapViewOfFile(mData);
+#else
+            munmap((void*)mData, mSize);
+#endif
+        }
+        mMapped = false;
+        mData = nullptr;
+        mSize = 0;
+        vector<char>().swap(mFallback);
+    }
+
+    const char* data() const { return mData; }
+    size_t size() const { return mSize; }
+    bool isMapped() const { return mMapped; }
+
+private:
+    bool readFallback(const string& path) {
+        ifstream file(path, ios::binary);
+        if (!file) return false;
+        file.seekg(0, ios::end);
+        mSize = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+        mFallback.resize(mSize);
+        file.read(mFallback.data(), mSize);
+        mData = mFallback.data();
+        return (bool)file;
+    }
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+    bool mMapped = false;
+    vector<char> mFallback;
+};
+
+// ---------------------------------------------------------------------
+// Decode job: one RX2 input and its WAV/TXT outputs
+// ---------------------------------------------------------------------
+struct DecodeJob {
+    string rx2Path;
+    string wavPath;
+    string txtPath;
+    string metaPath; // optional JSON/binary metadata output
+};
+
+// ---------------------------------------------------------------------
+// Structured metadata output (JSON or fixed-layout binary)
+// ---------------------------------------------------------------------
+enum MetaFormat { kMetaJSON, kMetaBinary };
+MetaFormat gMetaFormat = kMetaJSON;
+
+string jsonEscape(const char* text) {
+    ostringstream out;
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        switch (*c) {
+            case '"':  out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (*c < 0x20) {
+                    out << "\\u" << hex << setw(4) << setfill('0') << (int)*c << dec << setfill(' ');
+                } else {
+                    out << *c;
+                }
+        }
+    }
+    return out.str();
+}
+
+// {"peak": ..., "truePeak": ..., "rms": ..., "loudness": ..., "gain": ...};
+// levels that weren't measured or are silent are null.
+string levelsJSON(const LevelStats& stats) {
+    ostringstream json;
+    json << fixed << setprecision(2);
+    const char* names[] = { "peak", "truePeak", "rms", "loudness", "gain" };
+    const double values[] = { stats.peak, stats.truePeak, stats.rms, stats.loudness, stats.gain };
+    json << "{";
+    for (int i = 0; i < 5; i++) {
+        json << (i == 0 ? "\"" : ", \"") << names[i] << "\": ";
+        if (isfinite(values[i])) json << values[i];
+        else json << "null";
+    }
+    json << "}";
+    return json.str();
+}
+
+string metadataJSON(const DecodeJob& job, const REX::REXInfo& info,
+                    const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    ostringstream json;
+    json << "{\n";
+    json << "  \"version\": 1,\n";
+    json << "  \"input\": \"" << jsonEscape(job.rx2Path.c_str()) << "\",\n";
+    json << "  \"wav\": \"" << jsonEscape(job.wavPath.c_str()) << "\",\n";
+    json << "  \"channels\": " << info.fChannels << ",\n";
+    json << "  \"sampleRate\": " << outputSampleRate(info) << ",\n";
+    json << "  \"bitDepth\": " << info.fBitDepth << ",\n";
+    json << "  \"sampleFormat\": \"" << sampleFormatName(loop.format) << "\",\n";
+    json << "  \"tempo\": " << info.fTempo << ",\n";
+    json << "  \"originalTempo\": " << info.fOriginalTempo << ",\n";
+    json << "  \"bpm\": " << fixed << setprecision(3) << (info.fTempo / 1000.0) << ",\n";
+    json << "  \"renderTempo\": " << loop.tempo << ",\n";
+    json << "  \"ppqLength\": " << info.fPPQLength << ",\n";
+    json << "  \"timeSignature\": [" << info.fTimeSignNom << ", " << info.fTimeSignDenom << "],\n";
+    json << "  \"lengthFrames\": " << loop.lengthFrames << ",\n";
+    json << "  \"latencyCompensation\": " << loop.latency << ",\n";
+    json << "  \"latencyMode\": \"" << latencyModeName(gLatencyMode) << "\",\n";
+    if (loop.analyzed) json << "  \"levels\": " << levelsJSON(loop.levels) << ",\n";
+    if (!loop.slices.effectiveLength.empty() || loop.effectiveLength >= 0) {
+        json << "  \"effectiveLengthFrames\": ";
+        if (loop.effectiveLength >= 0) json << loop.effectiveLength;
+        else json << "null";
+        json << ",\n";
+    }
+    if (creator) {
+        json << "  \"creator\": {\"name\": \"" << jsonEscape(creator->fName)
+             << "\", \"copyright\": \"" << jsonEscape(creator->fCopyright)
+             << "\", \"url\": \"" << jsonEscape(creator->fURL)
+             << "\", \"email\": \"" << jsonEscape(creator->fEmail)
+             << "\", \"freeText\": \"" << jsonEscape(creator->fFreeText) << "\"},\n";
+    } else {
+        json << "  \"creator\": null,\n";
+    }
+    json << "  \"slices\": [";
+    const SliceTable& slices = loop.slices;
+    for (size_t i = 0; i < slices.size(); i++) {
+        json << (i == 0 ? "\n" : ",\n");
+        json << "    {\"ppq\": " << slices.ppqPos[i] << ", \"sampleLength\": " << slices.sampleLength[i]
+             << ", \"start\": " << slices.frameStart[i] << ", \"end\": " << slices.frameEnd[i];
+        if (i < slices.originalStart.size()) {
+            json << ", \"originalStart\": " << slices.originalStart[i];
+        }
+        if (i < slices.effectiveLength.size()) {
+            json << ", \"effectiveLength\": " << slices.effectiveLength[i];
+        }
+        if (i < loop.sliceFiles.size()) {
+            json << ", \"file\": \"" << jsonEscape(loop.sliceFiles[i].c_str()) << "\"";
+        }
+        if (i < loop.sliceLevels.size()) {
+            json << ", \"levels\": " << levelsJSON(loop.sliceLevels[i]);
+        }
+        json << "}";
+    }
+    json << (loop.slices.empty() ? "]\n" : "\n  ]\n");
+    json << "}\n";
+    return json.str();
+}
+
+bool writeMetadataJSON(const string& path, const DecodeJob& job, const REX::REXInfo& info,
+                       const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+    string json = metadataJSON(job, info, creator, loop);
+    file << json;
+    statsAdd(&JobStats::outputBytes, json.size());
+    return (bool)file;
+}
+
+// Binary layout, all integers little-endian:
+//   char[4]  magic "RX2M"
+//   uint32   version (2)
+//   int32    channels, sampleRate, sliceCount, tempo, originalTempo,
+//            ppqLength, timeSignNom, timeSignDenom, bitDepth
+//   int32    lengthFrames, latencyCompensation, renderTempo
+//   uint32   hasCreator (0/1)
+//   char[256] x5  creator name, copyright, url, email, free text
+//   uint32   slice record count, then per slice:
+//   int32    ppqPos, sampleLength, frameStart, frameEnd
+// Version 3 (written with --analyze, --snap or --tails) continues with
+//   uint32   sections present: 1 = levels, 2 = original starts, 4 = tails
+// and then those sections in that order. Levels are float32 bit patterns,
+// NaN where not measured and -inf for silence:
+//   float32  loop peak, truePeak, rms, loudness, gain
+//   float32  per slice: peak, truePeak, rms, loudness, gain
+// Original starts are the slice starts before --snap moved them:
+//   int32    per slice: originalStart
+// Tails are the effective lengths, -1 for a loop that wasn't measured:
+//   int32    loop effectiveLength, then per slice: effectiveLength
+const uint32_t kMetaSectionLevels = 1;
+const uint32_t kMetaSectionOriginalStarts = 2;
+const uint32_t kMetaSectionTails = 4;
+
+void appendLE32(string& out, uint32_t value) {
+    out.push_back((char)(value & 0xFF));
+    out.push_back((char)((value >> 8) & 0xFF));
+    out.push_back((char)((value >> 16) & 0xFF));
+    out.push_back((char)((value >> 24) & 0xFF));
+}
+
+string metadataBinary(const REX::REXInfo& info, const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    string out;
+    out.reserve(64 + 5 * 256 + loop.slices.size() * 16);
+    out.append("RX2M", 4);
+    bool snapped = !loop.slices.originalStart.empty();
+    bool tails = !loop.slices.effectiveLength.empty() || loop.effectiveLength >= 0;
+    appendLE32(out, (loop.analyzed || snapped || tails) ? 3 : 2);
+    const int32_t header[] = {
+        info.fChannels, outputSampleRate(info), info.fSliceCount, info.fTempo, info.fOriginalTempo,
+        info.fPPQLength, info.fTimeSignNom, info.fTimeSignDenom, info.fBitDepth,
+        loop.lengthFrames, loop.latency, loop.tempo
+    };
+    for (int32_t value : header) appendLE32(out, (uint32_t)value);
+    appendLE32(out, creator ? 1 : 0);
+    REX::REXCreatorInfo blank;
+    memset(&blank, 0, sizeof(blank));
+    const REX::REXCreatorInfo& c = creator ? *creator : blank;
+    const char* fields[] = { c.fName, c.fCopyright, c.fURL, c.fEmail, c.fFreeText };
+    for (const char* field : fields) {
+        char padded[256] = {0};
+        strncpy(padded, field, sizeof(padded) - 1);
+        out.append(padded, sizeof(padded));
+    }
+    appendLE32(out, (uint32_t)loop.slices.size());
+    const SliceTable& slices = loop.slices;
+    for (size_t i = 0; i < slices.size(); i++) {
+        appendLE32(out, (uint32_t)slices.ppqPos[i]);
+        appendLE32(out, (uint32_t)slices.sampleLength[i]);
+        appendLE32(out, (uint32_t)slices.frameStart[i]);
+        appendLE32(out, (uint32_t)slices.frameEnd[i]);
+    }
+    if (loop.analyzed || snapped || tails) {
+        appendLE32(out, (loop.analyzed ? kMetaSectionLevels : 0) | (snapped ? kMetaSectionOriginalStarts : 0)
+                        | (tails ? kMetaSectionTails : 0));
+    }
+    if (loop.analyzed) {
+        auto appendLevels = [&](const LevelStats& stats) {
+            const double values[] = { stats.peak, stats.truePeak, stats.rms, stats.loudness, stats.gain };
+            for (double value : values) {
+                float f = (float)value;
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                appendLE32(out, bits);
+            }
+        };
+        appendLevels(loop.levels);
+        for (size_t i = 0; i < slices.size(); i++) {
+            appendLevels(i < loop.sliceLevels.size() ? loop.sliceLevels[i] : LevelStats());
+        }
+    }
+    if (snapped) {
+        for (size_t i = 0; i < slices.size(); i++) appendLE32(out, (uint32_t)slices.originalStart[i]);
+    }
+    if (tails) {
+        appendLE32(out, (uint32_t)loop.effectiveLength);
+        for (size_t i = 0; i < slices.size(); i++) {
+            appendLE32(out, (uint32_t)(i < slices.effectiveLength.size() ? slices.effectiveLength[i] : -1));
+        }
+    }
+    return out;
+}
+
+bool writeMetadataBinary(const string& path, const REX::REXInfo& info,
+                         const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    string out = metadataBinary(info, creator, loop);
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+    file.write(out.data(), out.size());
+    statsAdd(&JobStats::outputBytes, out.size());
+    return (bool)file;
+}
+
+uint32_t readLE32(const unsigned char* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Reads back what writeMetadataBinary wrote. loop.format and sliceFiles
+// are not part of the layout and are left untouched.
+bool readMetadataBinary(const string& path, REX::REXInfo& info, REX::REXCreatorInfo& creator,
+                        bool& hasCreator, RenderedLoop& loop) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+    string in((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    const size_t fixedSize = 8 + 12 * 4 + 4 + 5 * 256 + 4;
+    if (in.size() < fixedSize || in.compare(0, 4, "RX2M") != 0) return false;
+    const unsigned char* p = (const unsigned char*)in.data();
+    uint32_t version = readLE32(p + 4);
+    if (version != 2 && version != 3) return false;
+    p += 8;
+    int32_t header[12];
+    for (int32_t& value : header) { value = (int32_t)readLE32(p); p += 4; }
+    info.fChannels = header[0];
+    info.fSampleRate = header[1];
+    info.fSliceCount = header[2];
+    info.fTempo = header[3];
+    info.fOriginalTempo = header[4];
+    info.fPPQLength = header[5];
+    info.fTimeSignNom = header[6];
+    info.fTimeSignDenom = header[7];
+    info.fBitDepth = header[8];
+    loop.lengthFrames = header[9];
+    loop.latency = header[10];
+    loop.tempo = header[11];
+    hasCreator = readLE32(p) != 0;
+    p += 4;
+    char* fields[] = { creator.fName, creator.fCopyright, creator.fURL, creator.fEmail, creator.fFreeText };
+    for (char* field : fields) {
+        memcpy(field, p, 256);
+        field[255] = '\0';
+        p += 256;
+    }
+    uint32_t sliceCount = readLE32(p);
+    p += 4;
+    size_t tableEnd = fixedSize + (size_t)sliceCount * 16;
+    uint32_t sections = 0;
+    if (version == 3) {
+        if (in.size() < tableEnd + 4) return false;
+        sections = readLE32((const unsigned char*)in.data() + tableEnd);
+    }
+    size_t sectionsSize = (version == 3) ? 4 : 0;
+    if (sections & kMetaSectionLevels) sectionsSize += ((size_t)sliceCount + 1) * 20;
+    if (sections & kMetaSectionOriginalStarts) sectionsSize += (size_t)sliceCount * 4;
+    if (sections & kMetaSectionTails) sectionsSize += ((size_t)sliceCount + 1) * 4;
+    if (in.size() != tableEnd + sectionsSize) return false;
+    loop.slices.resize(sliceCount);
+    SliceTable& slices = loop.slices;
+    for (size_t i = 0; i < sliceCount; i++) {
+        slices.ppqPos[i] = (int32_t)readLE32(p);
+        slices.sampleLength[i] = (int32_t)readLE32(p + 4);
+        slices.frameStart[i] = (int32_t)readLE32(p + 8);
+        slices.frameEnd[i] = (int32_t)readLE32(p + 12);
+        p += 16;
+    }
+    if (version == 3) p += 4;
+    loop.analyzed = (sections & kMetaSectionLevels) != 0;
+    loop.sliceLevels.clear();
+    auto readLevels = [&](LevelStats& stats) {
+        double* values[] = { &stats.peak, &stats.truePeak, &stats.rms, &stats.loudness, &stats.gain };
+        for (double* value : values) {
+            uint32_t bits = readLE32(p);
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            *value = f;
+            p += 4;
+        }
+    };
+    if (loop.analyzed) {
+        readLevels(loop.levels);
+        loop.sliceLevels.resize(sliceCount);
+        for (LevelStats& stats : loop.sliceLevels) readLevels(stats);
+    }
+    slices.originalStart.clear();
+    if (sections & kMetaSectionOriginalStarts) {
+        slices.originalStart.resize(sliceCount);
+        for (int32_t& start : slices.originalStart) { start = (int32_t)readLE32(p); p += 4; }
+    }
+    loop.effectiveLength = -1;
+    slices.effectiveLength.clear();
+    if (sections & kMetaSectionTails) {
+        loop.effectiveLength = (int32_t)readLE32(p);
+        p += 4;
+        slices.effectiveLength.resize(sliceCount);
+        for (int32_t& length : slices.effectiveLength) { length = (int32_t)readLE32(p); p += 4; }
+    }
+    return true;
+}
+
+// The --meta output for a job in the selected format, as bytes.
+string jobMetadata(const DecodeJob& job, const REX::REXInfo& info,
+                   const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    return (gMetaFormat == kMetaBinary) ? metadataBinary(info, creator, loop) : metadataJSON(job, info, creator, loop);
+}
+
+// Writes the --meta output for a job in the selected format.
+bool writeJobMetadata(const DecodeJob& job, const REX::REXInfo& info,
+                      const REX::REXCreatorInfo* creator, const RenderedLoop& loop) {
+    return (gMetaFormat == kMetaBinary)
+        ? writeMetadataBinary(job.metaPath, info, creator, loop)
+        : writeMetadataJSON(job.metaPath, job, info, creator, loop);
+}
+
+// ---------------------------------------------------------------------
+// Sampler exports: Octatrack .ot and Renoise .xrni next to the loop WAV
+// ---------------------------------------------------------------------
+// Set from --ot / --xrni (loop mode only). Both are written from the
+// rendered loop and its slice table, so the markers are exactly the ones
+// in the txt output: output.wav -> output.ot / output.xrni.
+bool gWriteOT = false;
+bool gWriteXRNI = false;
+
+const size_t kOTFileSize = 832;
+const int kOTMaxSlices = 64;
+
+// output.wav -> output.ot; paths without an extension get one appended.
+string replaceExtension(const string& path, const char* extension) {
+    return splitExtension(path).first + extension;
+}
+
+// "loops/Amen Break.rx2" -> "Amen Break"
+string pathStem(const string& path) {
+    size_t slash = path.find_last_of("/\\");
+    string name = (slash == string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+void appendBE32(string& out, uint32_t value) {
+    out.push_back((char)((value >> 24) & 0xFF));
+    out.push_back((char)((value >> 16) & 0xFF));
+    out.push_back((char)((value >> 8) & 0xFF));
+    out.push_back((char)(value & 0xFF));
+}
+
+void appendBE16(string& out, uint16_t value) {
+    out.push_back((char)((value >> 8) & 0xFF));
+    out.push_back((char)(value & 0xFF));
+}
+
+void appendLE16(string& out, uint16_t value) {
+    out.push_back((char)(value & 0xFF));
+    out.push_back((char)((value >> 8) & 0xFF));
+}
+
+// Octatrack sample settings, byte for byte what PakettiRX2Loader.lua's
+// writeOTFileStandalone writes (OctaChainer layout, big-endian):
+//   "FORM" 0 "DPS1SMPA", 7 unknown bytes (00 00 00 00 00 02 00)
+//   int32    tempo (BPM * 24), trim length, loop length (bars * 25),
+//            stretch (0 = off), loop (0 = off)
+//   int16    gain (48 = 0 dB)
+//   uint8    quantize (0xFF = direct)
+//   int32    trim start, trim end (frames), loop point
+//   int32 x3 per slice: start, end, loop point (0xFFFFFFFF = off),
+//            64 slots, unused ones zero
+//   int32    slice count (at most 64)
+//   uint16   checksum: sum of bytes 16..829
+// The tempo is the one the loop was rendered at.
+bool writeOctatrackFile(const string& path, const REX::REXInfo& info, const RenderedLoop& loop) {
+    double bpm = loop.tempo / 1000.0;
+    int64_t length = loop.lengthFrames;
+    uint32_t bars = (uint32_t)floor(bpm * length / (outputSampleRate(info) * 60.0 * 4.0) + 0.5);
+
+    string ot;
+    ot.reserve(kOTFileSize);
+    ot.append("FORM\0\0\0\0DPS1SMPA", 16);
+    ot.append("\0\0\0\0\0\x02\0", 7);
+    appendBE32(ot, (uint32_t)floor(bpm * 24.0));
+    appendBE32(ot, bars * 25);
+    appendBE32(ot, bars * 25);
+    appendBE32(ot, 0);
+    appendBE32(ot, 0);
+    appendBE16(ot, 48);
+    ot.push_back((char)0xFF);
+    appendBE32(ot, 0);
+    appendBE32(ot, (uint32_t)length);
+    appendBE32(ot, 0);
+
+    const vector<int32_t>& markers = loop.slices.frameStart;
+    int sliceCount = min((int)markers.size(), kOTMaxSlices);
+    for (int i = 0; i < kOTMaxSlices; i++) {
+        if (i >= sliceCount) {
+            for (int field = 0; field < 3; field++) appendBE32(ot, 0);
+            continue;
+        }
+        // Markers are 1-based Renoise positions, the Octatrack counts from 0
+        int64_t start = (i == 0) ? 0 : markers[i] - 1;
+        int64_t end = (i + 1 < sliceCount) ? markers[i + 1] - 2 : length - 1;
+        end = max(start, min(end, length - 1));
+        appendBE32(ot, (uint32_t)start);
+        appendBE32(ot, (uint32_t)end);
+        appendBE32(ot, 0xFFFFFFFF);
+    }
+    appendBE32(ot, (uint32_t)sliceCount);
+
+    uint16_t checksum = 0;
+    for (size_t i = 16; i < ot.size(); i++) checksum = (uint16_t)(checksum + (unsigned char)ot[i]);
+    appendBE16(ot, checksum);
+    ot.resize(kOTFileSize, '\0');
+
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+    file.write(ot.data(), ot.size());
+    statsAdd(&JobStats::outputBytes, ot.size());
+    return (bool)file;
+}
+
+string xmlEscape(const string& text) {
+    string out;
+    for (char c : text) {
+        switch (c) {
+            case '&':  out += "&amp;"; break;
+            case '<':  out += "&lt;"; break;
+            case '>':  out += "&gt;"; break;
+            case '"':  out += "&quot;"; break;
+            case '\'': out += "&apos;"; break;
+            default:
+                // Control characters are not allowed in XML 1.0
+                if ((unsigned char)c >= 0x20 || c == '\t' || c == '\n') out += c;
+        }
+    }
+    return out;
+}
+
+// The Instrument.xml of a sliced instrument: one sample holding the loop
+// (on C-4) with a slice marker per slice, and the slice aliases Renoise
+// keeps for it, mapped chromatically from C#4. Anything left out takes
+// Renoise's defaults.
+string xrniInstrumentXml(const string& name, const RenderedLoop& loop) {
+    const int kBaseNote = 48;
+    const int kLastNote = 119;
+    ostringstream xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xml << "<RenoiseInstrument doc_version=\"34\">\n";
+    xml << "  <Name>" << xmlEscape(name) << "</Name>\n";
+    xml << "  <GlobalProperties>\n";
+    xml << "    <BeatsPerMin>" << lround(loop.tempo / 1000.0) << "</BeatsPerMin>\n";
+    xml << "  </GlobalProperties>\n";
+    xml << "  <SampleGenerator>\n";
+    xml << "    <Samples>\n";
+    xml << "      <Sample>\n";
+    xml << "        <Name>" << xmlEscape(name) << "</Name>\n";
+    xml << "        <LoopMode>Off</LoopMode>\n";
+    xml << "        <IsAlias>false</IsAlias>\n";
+    xml << "        <SliceMarkers>\n";
+    for (int32_t marker : loop.slices.frameStart) {
+        xml << "          <SliceMarker>\n";
+        xml << "            <SamplePosition>" << marker << "</SamplePosition>\n";
+        xml << "          </SliceMarker>\n";
+    }
+    xml << "        </SliceMarkers>\n";
+    xml << "        <Mapping>\n";
+    xml << "          <BaseNote>" << kBaseNote << "</BaseNote>\n";
+    xml << "          <NoteStart>" << kBaseNote << "</NoteStart>\n";
+    xml << "          <NoteEnd>" << kBaseNote << "</NoteEnd>\n";
+    xml << "        </Mapping>\n";
+    xml << "      </Sample>\n";
+    for (size_t i = 0; i < loop.slices.size(); i++) {
+        int note = min(kBaseNote + 1 + (int)i, kLastNote);
+        xml << "      <Sample>\n";
+        xml << "        <Name>Slice #" << setfill('0') << setw(2) << (i + 1) << setfill(' ') << "</Name>\n";
+        xml << "        <LoopMode>Off</LoopMode>\n";
+        xml << "        <IsAlias>true</IsAlias>\n";
+        xml << "        <Mapping>\n";
+        xml << "          <BaseNote>" << note << "</BaseNote>\n";
+        xml << "          <NoteStart>" << note << "</NoteStart>\n";
+        xml << "          <NoteEnd>" << note << "</NoteEnd>\n";
+        xml << "        </Mapping>\n";
+        xml << "      </Sample>\n";
+    }
+    xml << "    </Samples>\n";
+    xml << "    <SelectedSampleIndex>0</SelectedSampleIndex>\n";
+    xml << "  </SampleGenerator>\n";
+    xml << "  <ActiveGeneratorTab>Samples</ActiveGeneratorTab>\n";
+    xml << "</RenoiseInstrument>\n";
+    return xml.str();
+}
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t size) {
+    static uint32_t table[256];
+    static once_flag tableOnce;
+    call_once(tableOnce, []() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    });
+    const unsigned char* bytes = (const unsigned char*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Renoise instrument archive: a zip with Instrument.xml and the loop WAV
+// as SampleData/Sample00 (<name>).wav. Entries are stored uncompressed
+// (the WAV would barely deflate) with a fixed 1980-01-01 timestamp, so
+// the same render always gives the same archive. The WAV is mapped, not
+// re-rendered.
+bool writeRenoiseInstrument(const string& path, const string& wavPath, const string& name,
+                            const RenderedLoop& loop) {
+    MappedFile wav;
+    if (!wav.open(wavPath) || wav.size() > 0xFFFFFFF0U) return false;
+    string xml = xrniInstrumentXml(name, loop);
+
+    struct ZipEntry { string name; const char* data; uint32_t size; uint32_t crc; uint32_t offset; };
+    ZipEntry entries[] = {
+        { "Instrument.xml", xml.data(), (uint32_t)xml.size(), 0, 0 },
+        { "SampleData/Sample00 (" + name + ").wav", (const char*)wav.data(), (uint32_t)wav.size(), 0, 0 }
+    };
+    const uint16_t kVersion = 20;        // 2.0: stored entries
+    const uint16_t kFlagUtf8 = 0x0800;   // names are UTF-8
+    const uint16_t kDosDate = (0 << 9) | (1 << 5) | 1;
+
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+    uint32_t offset = 0;
+    for (ZipEntry& e : entries) {
+        e.crc = crc32Update(0, e.data, e.size);
+        e.offset = offset;
+        string header;
+        appendLE32(header, 0x04034B50);
+        appendLE16(header, kVersion);
+        appendLE16(header, kFlagUtf8);
+        appendLE16(header, 0);           // stored
+        appendLE16(header, 0);           // time
+        appendLE16(header, kDosDate);
+        appendLE32(header, e.crc);
+        appendLE32(header, e.size);
+        appendLE32(header, e.size);
+        appendLE16(header, (uint16_t)e.name.size());
+        appendLE16(header, 0);
+        header += e.name;
+        file.write(header.data(), header.size());
+        file.write(e.data, e.size);
+        offset += (uint32_t)header.size() + e.size;
+    }
+    string directory;
+    for (const ZipEntry& e : entries) {
+        appendLE32(directory, 0x02014B50);
+        appendLE16(directory, kVersion);
+        appendLE16(directory, kVersion);
+        appendLE16(directory, kFlagUtf8);
+        appendLE16(directory, 0);
+        appendLE16(directory, 0);
+        appendLE16(directory, kDosDate);
+        appendLE32(directory, e.crc);
+        appendLE32(directory, e.size);
+        appendLE32(directory, e.size);
+        appendLE16(directory, (uint16_t)e.name.size());
+        appendLE16(directory, 0);        // extra
+        appendLE16(directory, 0);        // comment
+        appendLE16(directory, 0);        // disk
+        appendLE16(directory, 0);        // internal attributes
+        appendLE32(directory, 0);        // external attributes
+        appendLE32(directory, e.offset);
+        directory += e.name;
+    }
+    uint16_t count = (uint16_t)(sizeof(entries) / sizeof(entries[0]));
+    appendLE32(directory, 0x06054B50);
+    appendLE16(directory, 0);
+    appendLE16(directory, 0);
+    appendLE16(directory, count);
+    appendLE16(directory, count);
+    appendLE32(directory, (uint32_t)(directory.size() - 12));
+    appendLE32(directory, offset);
+    appendLE16(directory, 0);
+    file.write(directory.data(), directory.size());
+    statsAdd(&JobStats::outputBytes, offset + directory.size());
+    return (bool)file;
+}
+
+// Writes the --ot / --xrni outputs of a finished loop render.
+bool writeSamplerExports(const DecodeJob& job, const REX::REXInfo& info, const RenderedLoop& loop, ostream& log) {
+    if (!gWriteOT && !gWriteXRNI) return true;
+    StageTimer exportTimer("export");
+    bool ok = true;
+    if (gWriteOT) {
+        string otPath = replaceExtension(job.wavPath, ".ot");
+        if (writeOctatrackFile(otPath, info, loop)) {
+            if (logSummary()) log << "Octatrack settings written to: " << otPath << "\n";
+        } else {
+            cerr << "Failed to write Octatrack file: " << otPath << endl;
+            ok = false;
+        }
+    }
+    if (gWriteXRNI) {
+        string xrniPath = replaceExtension(job.wavPath, ".xrni");
+        if (writeRenoiseInstrument(xrniPath, job.wavPath, pathStem(job.rx2Path), loop)) {
+            if (logSummary()) log << "Renoise instrument written to: " << xrniPath << "\n";
+        } else {
+            cerr << "Failed to write Renoise instrument: " << xrniPath << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------
+// Decode cache: reuse the outputs of an earlier decode of the same bytes
+// ---------------------------------------------------------------------
+// Set from --cache / --cache-limit. Entries live in gCacheDir, one
+// directory per key, named after a 64-bit FNV-1a hash of the RX2 bytes
+// and every option that changes the rendered output:
+//
+//   <key>/meta.rx2m        header, creator and slice table (RX2M layout)
+//   <key>/audio.wav        the loop, or audio_001.wav, ... in slice mode
+//
+// An entry is assembled in a private ".tmp-*" directory and renamed into
+// place, so other decoder processes only ever see complete entries; if
+// two processes store the same key, the second rename fails and its copy
+// is dropped. Eviction renames an entry to ".evict-*" before deleting it,
+// and a hit that loses a file to eviction falls back to a normal decode.
+// Hits refresh meta.rx2m's modification time, which drives the LRU order
+// used to keep the directory under gCacheLimitBytes. Only SDK renders are
+// cached; the --native-rex path returns before the cache is consulted.
+namespace fs = std::filesystem;
+
+string gCacheDir;
+uint64_t gCacheLimitBytes = 1024ULL * 1024 * 1024;
+
+fs::path cacheFsPath(const string& path) {
+    return fs::u8path(path);
+}
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Every setting that changes the WAV, txt or metadata contents of one
+// render at `tempo` (0 = the file's tempo).
+string cacheOptionsKey(int tempo) {
+    ostringstream key;
+    key << "v2"
+        << " rate=" << gOutputSampleRate
+        << " tempo=" << tempo
+        << " format=" << (int)gSampleFormat
+        << " dither=" << (gDither ? 1 : 0)
+        << " slices=" << (gSliceMode ? 1 : 0)
+        << " latency=" << latencyModeName(gLatencyMode) << ":" << gLatencyFrames;
+    if (gAnalyze) key << " levels=" << (int)gNormalizeMode << ":" << gNormalizeTarget;
+    if (gSnapZeroCrossing) key << " snap=" << gSnapFrames;
+    if (gTails) key << " tails=" << gTailThresholdDb << ":" << gTailHoldMs << ":" << gTailFadeMs << ":" << (gTrim ? 1 : 0);
+    return key.str();
+}
+
+// Hash of the RX2 file's bytes and size; false if it can't be read.
+bool hashRx2File(const string& rx2Path, uint64_t& hash) {
+    MappedFile rx2File;
+    if (!rx2File.open(rx2Path)) return false;
+    hash = fnv1a(1469598103934665603ULL, rx2File.data(), rx2File.size());
+    uint64_t size = rx2File.size();
+    hash = fnv1a(hash, &size, sizeof(size));
+    return true;
+}
+
+// Hex cache key of one render of the file with hash fileHash.
+string decodeCacheKey(uint64_t fileHash, int tempo) {
+    string options = cacheOptionsKey(tempo);
+    uint64_t hash = fnv1a(fileHash, options.data(), options.size());
+    ostringstream key;
+    key << hex << setw(16) << setfill('0') << hash;
+    return key.str();
+}
+
+// Unique name for a private staging/eviction directory.
+string cacheUniqueName(const char* prefix) {
+    static atomic<uint64_t> counter(0);
+#if defined(_WIN32)
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    ostringstream name;
+    name << prefix << pid << "-" << chrono::steady_clock::now().time_since_epoch().count()
+         << "-" << counter++;
+    return name.str();
+}
+
+// Output WAV names inside an entry, matching the job's layout.
+vector<string> cacheAudioNames(const RenderedLoop& loop) {
+    vector<string> names;
+    if (gSliceMode) {
+        for (size_t i = 0; i < loop.slices.size(); i++) names.push_back(sliceWavPath("audio.wav", (int)i));
+    } else {
+        names.push_back("audio.wav");
+    }
+    return names;
+}
+
+// Copies a cached entry to the job's outputs. Returns false on a miss or
+// if the entry disappeared half way; the caller then decodes normally.
+bool cacheFetch(const string& key, const DecodeJob& job, ostream& log, REX::REXInfo* infoOut) {
+    fs::path entry = cacheFsPath(gCacheDir) / key;
+    REX::REXInfo info;
+    REX::REXCreatorInfo creator;
+    bool hasCreator = false;
+    RenderedLoop loop;
+    if (!readMetadataBinary((entry / "meta.rx2m").u8string(), info, creator, hasCreator, loop)) {
+        error_code ec;
+        if (fs::exists(entry, ec)) {
+            // Unreadable entry: move it out of the way so this decode can replace it
+            fs::path doomed = entry.parent_path() / cacheUniqueName(".evict-");
+            fs::rename(entry, doomed, ec);
+            if (!ec) fs::remove_all(doomed, ec);
+        }
+        return false;
+    }
+    loop.format = resolveSampleFormat(info);
+
+    vector<string> names = cacheAudioNames(loop);
+    vector<string> targets;
+    if (gSliceMode) {
+        for (size_t i = 0; i < names.size(); i++) targets.push_back(sliceWavPath(job.wavPath, (int)i));
+        loop.sliceFiles = targets;
+    } else {
+        targets.push_back(job.wavPath);
+    }
+    error_code ec;
+    for (size_t i = 0; i < names.size(); i++) {
+        fs::copy_file(entry / names[i], cacheFsPath(targets[i]), fs::copy_options::overwrite_existing, ec);
+        if (ec) return false;
+        uintmax_t bytes = fs::file_size(entry / names[i], ec);
+        if (!ec) statsAdd(&JobStats::outputBytes, bytes);
+    }
+    if (!writeSliceText(job.txtPath, loop)) {
+        cerr << "Failed to open output text file: " << job.txtPath << endl;
+    }
+    if (!job.metaPath.empty() && !writeJobMetadata(job, info, hasCreator ? &creator : nullptr, loop)) {
+        cerr << "Failed to write metadata file: " << job.metaPath << endl;
+        return false;
+    }
+    if (!writeSamplerExports(job, info, loop, log)) return false;
+    fs::last_write_time(entry / "meta.rx2m", fs::file_time_type::clock::now(), ec);
+    if (infoOut) *infoOut = info;
+    if (logSummary()) log << "Cache hit: " << key << " -> " << job.wavPath << "\n";
+    return true;
+}
+
+// Scans the cache directory and, if it holds more than gCacheLimitBytes,
+// drops least recently used entries until it is down to
+// kCacheEvictTarget of the limit. Returns the bytes left.
+const double kCacheEvictTarget = 0.9;
+
+uint64_t cacheEvict() {
+    struct Entry { fs::path path; fs::file_time_type used; uint64_t bytes; };
+    vector<Entry> entries;
+    uint64_t total = 0;
+    error_code ec;
+    for (fs::directory_iterator it(cacheFsPath(gCacheDir), ec), end; !ec && it != end; it.increment(ec)) {
+        string name = it->path().filename().u8string();
+        if (name.empty()) continue;
+        if (name[0] == '.') {
+            // Leftovers of a process that died while storing or evicting
+            fs::file_time_type modified = fs::last_write_time(it->path(), ec);
+            if (!ec && fs::file_time_type::clock::now() - modified > chrono::hours(1)) {
+                fs::remove_all(it->path(), ec);
+            }
+            ec.clear();
+            continue;
+        }
+        Entry e = { it->path(), fs::last_write_time(it->path() / "meta.rx2m", ec), 0 };
+        if (ec) { ec.clear(); continue; }
+        for (fs::directory_iterator file(it->path(), ec); !ec && file != end; file.increment(ec)) {
+            uintmax_t size = fs::file_size(file->path(), ec);
+            if (!ec) e.bytes += size;
+        }
+        ec.clear();
+        total += e.bytes;
+        entries.push_back(e);
+    }
+    if (total <= gCacheLimitBytes) return total;
+    uint64_t target = (uint64_t)(gCacheLimitBytes * kCacheEvictTarget);
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& e : entries) {
+        if (total <= target) break;
+        fs::path doomed = e.path.parent_path() / cacheUniqueName(".evict-");
+        fs::rename(e.path, doomed, ec);
+        if (ec) { ec.clear(); continue; } // another process got there first
+        fs::remove_all(doomed, ec);
+        total -= e.bytes;
+    }
+    return total;
+}
+
+// What this process knows of the cache size: one full scan on the first
+// store, then each store adds its own bytes. Only when that passes the
+// limit is the directory scanned again (which also picks up other
+// processes' entries) and trimmed, so a batch doesn't walk the whole cache
+// per file. Evicting down to kCacheEvictTarget leaves room for the next
+// stores before another scan.
+mutex gCacheSizeMutex;
+bool gCacheSizeKnown = false;
+uint64_t gCacheBytes = 0;
+
+void cacheAccount(uint64_t storedBytes) {
+    lock_guard<mutex> lock(gCacheSizeMutex);
+    if (gCacheSizeKnown) gCacheBytes += storedBytes;
+    if (!gCacheSizeKnown || gCacheBytes > gCacheLimitBytes) {
+        gCacheBytes = cacheEvict();
+        gCacheSizeKnown = true;
+    }
+}
+
+// Stores a finished decode under `key`. Failures only cost the cache entry.
+void cacheStore(const string& key, const DecodeJob& job, const REX::REXInfo& info,
+                const REX::REXCreatorInfo* creator, const RenderedLoop& loop, ostream& log) {
+    fs::path root = cacheFsPath(gCacheDir);
+    error_code ec;
+    fs::create_directories(root, ec);
+    fs::path staging = root / cacheUniqueName(".tmp-");
+    if (!fs::create_directory(staging, ec)) return;
+
+    vector<string> names = cacheAudioNames(loop);
+    bool ok = writeMetadataBinary((staging / "meta.rx2m").u8string(), info, creator, loop);
+    for (size_t i = 0; ok && i < names.size(); i++) {
+        string source = gSliceMode ? loop.sliceFiles[i] : job.wavPath;
+        ok = fs::copy_file(cacheFsPath(source), staging / names[i], ec) && !ec;
+    }
+    uint64_t bytes = 0;
+    for (fs::directory_iterator file(staging, ec), end; ok && !ec && file != end; file.increment(ec)) {
+        uintmax_t size = fs::file_size(file->path(), ec);
+        if (!ec) bytes += size;
+    }
+    ec.clear();
+    if (ok) {
+        fs::rename(staging, root / key, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        fs::remove_all(staging, ec);
+        return;
+    }
+    if (logSummary()) log << "Cached as: " << key << "\n";
+    cacheAccount(bytes);
+}
+
+// Loads an RX2 file into a new REX handle set up for rendering at the
+// --sample-rate target (the file's native rate by default). On success
+// `info` holds the header as seen after the sample rate change; renders
+// take their rate from outputSampleRate(), not info.fSampleRate. On
+// failure no handle is left open.
+REX::REXError openRexHandle(const string& rx2Path, REX::REXHandle& handle, REX::REXInfo& info, ostream& log) {
+    handle = nullptr;
+
+    // Map the RX2 file into memory (falls back to a plain read)
+    StageTimer readTimer("read");
+    MappedFile rx2File;
+    if (!rx2File.open(rx2Path)) {
+        cerr << "Failed to open RX2 file: " << rx2Path << endl;
+        return REX::kREXError_Undefined;
+    }
+    size_t fileSize = rx2File.size();
+    readTimer.stop();
+    statsAdd(&JobStats::inputBytes, fileSize);
+    if (logSummary()) {
+        log << "Loaded RX2 file: " << rx2Path << ", size: " << fileSize << " bytes"
+            << (rx2File.isMapped() ? " (mapped)" : "") << "\n";
+    }
+
+    // Create a REX handle
+    StageTimer createTimer("create");
+    REX::REXError createErr = sdkCall(REX::REXCreate, &handle, rx2File.data(), static_cast<int>(fileSize), nullptr, nullptr);
+    // REXCreate has parsed everything it needs; drop the input right away
+    rx2File.release();
+    createTimer.stop();
+    statsAdd(&JobStats::sdkCalls, 1);
+    if (logDebug()) log << "REXCreate returned: " << createErr << ", handle: " << handle << "\n";
+    if (createErr != REX::kREXError_NoError || !handle) {
+        cerr << "REXCreate failed or returned null handle." << endl;
+        return (createErr != REX::kREXError_NoError) ? createErr : REX::kREXError_Undefined;
+    }
+
+    // Extract header information
+    StageTimer infoTimer("info");
+    statsAdd(&JobStats::sdkCalls, 3); // REXGetInfo, REXSetOutputSampleRate, REXGetInfo
+    REX::REXError infoErr = sdkCall(REX::REXGetInfo, handle, sizeof(info), &info);
+    if (infoErr != REX::kREXError_NoError) {
+        cerr << "REXGetInfo failed with error: " << infoErr << endl;
+        sdkCall(REX::REXDelete, &handle);
+        return infoErr;
+    }
+    
+    // Set output sample rate (native rate unless --sample-rate is given)
+    REX::REXError sampleRateErr = sdkCall(REX::REXSetOutputSampleRate, handle, outputSampleRate(info));
+    if (sampleRateErr != REX::kREXError_NoError) {
+        cerr << "REXSetOutputSampleRate failed with error: " << sampleRateErr << endl;
+        sdkCall(REX::REXDelete, &handle);
+        return sampleRateErr;
+    }
+    
+    // Re-fetch info after setting sample rate
+    infoErr = sdkCall(REX::REXGetInfo, handle, sizeof(info), &info);
+    if (infoErr != REX::kREXError_NoError) {
+        cerr << "REXGetInfo #2 failed with error: " << infoErr << endl;
+        sdkCall(REX::REXDelete, &handle);
+        return infoErr;
+    }
+    return REX::kREXError_NoError;
+}
+
+// ---------------------------------------------------------------------
+// Pipeline statistics output: JSON lines per job, Chrome trace
+// ---------------------------------------------------------------------
+// --stats FILE appends one line per finished job ("-" = stderr):
+//   {"input": ..., "status": "OK", "error": 0, "thread": 1, "startMs": ...,
+//    "wallMs": ..., "stages": {"read": {"ms": ..., "count": 1}, ...},
+//    "inputBytes": ..., "outputBytes": ..., "frames": ..., "sdkCalls": ...,
+//    "renderCalls": ..., "peakMemoryBytes": ...}
+// Stages appear in the order they first finished. Peak memory is the
+// process's so far, so in a batch it only grows.
+// --trace FILE writes every job and stage span as Chrome trace events
+// (chrome://tracing, Perfetto) when the run ends, one track per worker.
+string gStatsPath;
+string gTracePath;
+ofstream gStatsFile;
+mutex gStatsMutex;
+vector<JobStats> gTraceJobs; // finished jobs, kept for the trace
+
+bool openStatsOutputs() {
+    if (gStatsPath.empty() || gStatsPath == "-") return true;
+    gStatsFile.open(gStatsPath, ios::app);
+    if (!gStatsFile) {
+        cerr << "Failed to open stats file: " << gStatsPath << endl;
+        return false;
+    }
+    return true;
+}
+
+void recordJobStats(JobStats& stats, REX::REXError err, int64_t startUs, int64_t wallUs) {
+    struct StageTotal { const char* name; int64_t us; int count; };
+    vector<StageTotal> totals;
+    for (const StageSpan& span : stats.spans) {
+        auto it = find_if(totals.begin(), totals.end(), [&](const StageTotal& t) { return strcmp(t.name, span.name) == 0; });
+        if (it == totals.end()) totals.push_back({ span.name, span.durationUs, 1 });
+        else { it->us += span.durationUs; it->count++; }
+    }
+    ostringstream json;
+    json << fixed << setprecision(3);
+    json << "{\"input\": \"" << jsonEscape(stats.input.c_str()) << "\""
+         << ", \"status\": \"" << (err == REX::kREXError_NoError ? "OK" : "FAIL") << "\""
+         << ", \"error\": " << err
+         << ", \"thread\": " << stats.thread
+         << ", \"startMs\": " << startUs / 1000.0
+         << ", \"wallMs\": " << wallUs / 1000.0
+         << ", \"stages\": {";
+    for (size_t i = 0; i < totals.size(); i++) {
+        json << (i == 0 ? "" : ", ") << "\"" << totals[i].name << "\": {\"ms\": " << totals[i].us / 1000.0
+             << ", \"count\": " << totals[i].count << "}";
+    }
+    json << "}"
+         << ", \"inputBytes\": " << stats.inputBytes
+         << ", \"outputBytes\": " << stats.outputBytes
+         << ", \"frames\": " << stats.frames
+         << ", \"sdkCalls\": " << stats.sdkCalls
+         << ", \"renderCalls\": " << stats.renderCalls
+         << ", \"peakMemoryBytes\": " << peakMemoryBytes() << "}\n";
+
+    lock_guard<mutex> lock(gStatsMutex);
+    if (!gStatsPath.empty()) {
+        ostream& out = (gStatsPath == "-") ? cerr : gStatsFile;
+        out << json.str() << flush;
+    }
+    if (!gTracePath.empty()) {
+        stats.spans.push_back({ "job", startUs, wallUs });
+        gTraceJobs.push_back(std::move(stats));
+    }
+}
+
+// Runs one job (a decode, stream or probe) with its statistics recorded.
+template <typename Work>
+REX::REXError withJobStats(const string& input, Work work) {
+    if (!gStatsEnabled) return work();
+    JobStats stats;
+    stats.input = input;
+    stats.thread = statsThreadId();
+    int64_t startUs = statsNowUs();
+    tJobStats = &stats;
+    REX::REXError err = work();
+    tJobStats = nullptr;
+    recordJobStats(stats, err, startUs, statsNowUs() - startUs);
+    return err;
+}
+
+// Job spans are named after the input file and carry its path; stage
+// spans nest inside them on the same track.
+bool writeTraceFile() {
+    if (gTracePath.empty()) return true;
+    ofstream file(gTracePath, ios::binary);
+    if (!file) {
+        cerr << "Failed to write trace file: " << gTracePath << endl;
+        return false;
+    }
+    lock_guard<mutex> lock(gStatsMutex);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const JobStats& job : gTraceJobs) {
+        string input = jsonEscape(job.input.c_str());
+        string name = jsonEscape(pathStem(job.input).c_str());
+        for (const StageSpan& span : job.spans) {
+            bool isJob = strcmp(span.name, "job") == 0;
+            file << (first ? "\n" : ",\n")
+                 << "{\"name\": \"" << (isJob ? name : string(span.name)) << "\""
+                 << ", \"cat\": \"" << (isJob ? "job" : "stage") << "\""
+                 << ", \"ph\": \"X\", \"ts\": " << span.startUs << ", \"dur\": " << span.durationUs
+                 << ", \"pid\": 1, \"tid\": " << job.thread
+                 << ", \"args\": {\"input\": \"" << input << "\"}}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return (bool)file;
+}
+
+// ---------------------------------------------------------------------
+// Native REX (v1) parser: no SDK, same outputs as the RX2 path
+// ---------------------------------------------------------------------
+// Set from --native-rex. A legacy .rex file is an AIFF (or AIFC) file
+// holding the loop as plain PCM in its SSND chunk, plus a "REX " chunk
+// whose slice table starts 1032 bytes after the chunk id: 12-byte
+// entries whose first big-endian dword is a slice's frame offset, ended
+// by 0 or a repeated offset. Each slice is preceded in the audio by a
+// 256-frame header that ends at that offset; the parser drops those
+// headers, like PakettiREXLoader.lua, and puts a marker at frame 1 and
+// at the first frame of every slice.
+//
+// REX1 files carry no tempo or PPQ information here, so tempo, PPQ and
+// the slice table's PPQ column are 0 in the metadata. The native path
+// only takes loop-mode jobs at the file's own rate and tempo; anything
+// else (and any input that isn't such an AIFF) still goes to the SDK.
+// That includes --ot and --xrni jobs, as both files need the tempo.
+bool gNativeRex = false;
+
+const int kRex1HeaderFrames = 256;
+const size_t kRex1SliceTableOffset = 1032;
+const size_t kRex1SliceEntrySize = 12;
+const int kRex1MaxSlices = 256;
+
+struct Rex1File {
+    int channels = 0;
+    int bitDepth = 0;
+    int sampleRate = 0;
+    uint32_t frames = 0;
+    const unsigned char* audio = nullptr; // interleaved PCM
+    bool littleEndian = false;            // AIFC 'sowt'
+    vector<uint32_t> sliceOffsets;        // sorted
+};
+
+uint32_t readBE32(const unsigned char* in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+}
+
+uint16_t readBE16(const unsigned char* in) {
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+// 80-bit IEEE extended (AIFF sample rate) to double
+double readExtended80(const unsigned char* in) {
+    int exponent = ((in[0] & 0x7F) << 8) | in[1];
+    uint64_t mantissa = 0;
+    for (int i = 0; i < 8; i++) mantissa = (mantissa << 8) | in[2 + i];
+    if (exponent == 0 && mantissa == 0) return 0.0;
+    double value = ldexp((double)mantissa, exponent - 16383 - 63);
+    return (in[0] & 0x80) ? -value : value;
+}
+
+// Parses the AIFF chunks of a REX1 file. Returns false (and leaves `rex`
+// unusable) if this isn't one; `corrupt` tells a damaged REX1 file apart
+// from a file of another kind.
+bool parseRex1(const unsigned char* data, size_t size, Rex1File& rex, bool& corrupt) {
+    corrupt = false;
+    if (size < 12 || memcmp(data, "FORM", 4) != 0) return false;
+    bool aifc = memcmp(data + 8, "AIFC", 4) == 0;
+    if (!aifc && memcmp(data + 8, "AIFF", 4) != 0) return false;
+
+    const unsigned char* comm = nullptr;
+    const unsigned char* ssnd = nullptr;
+    const unsigned char* rexChunk = nullptr;
+    size_t commSize = 0, ssndSize = 0, rexSize = 0;
+    size_t end = min(size, (size_t)readBE32(data + 4) + 8);
+    for (size_t pos = 12; pos + 8 <= end; ) {
+        size_t chunkSize = readBE32(data + pos + 4);
+        const unsigned char* body = data + pos + 8;
+        size_t available = min(chunkSize, end - pos - 8);
+        if (memcmp(data + pos, "COMM", 4) == 0) { comm = body; commSize = available; }
+        else if (memcmp(data + pos, "SSND", 4) == 0) { ssnd = body; ssndSize = available; }
+        else if (memcmp(data + pos, "REX ", 4) == 0) { rexChunk = data + pos; rexSize = available + 8; }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    if (rexChunk == nullptr) return false;
+
+    corrupt = true;
+    if (comm == nullptr || commSize < 18 || ssnd == nullptr || ssndSize < 8) return false;
+    rex.channels = (int16_t)readBE16(comm);
+    rex.frames = readBE32(comm + 2);
+    rex.bitDepth = (int16_t)readBE16(comm + 6);
+    rex.sampleRate = (int)lround(readExtended80(comm + 8));
+    rex.littleEndian = aifc && commSize >= 22 && memcmp(comm + 18, "sowt", 4) == 0;
+    if (aifc && commSize >= 22 && !rex.littleEndian && memcmp(comm + 18, "NONE", 4) != 0
+        && memcmp(comm + 18, "twos", 4) != 0) {
+        return false; // compressed AIFC
+    }
+    if (rex.channels < 1 || rex.channels > 2 || rex.sampleRate <= 0 || rex.frames == 0) return false;
+    if (rex.bitDepth != 8 && rex.bitDepth != 16 && rex.bitDepth != 24 && rex.bitDepth != 32) return false;
+    size_t audioOffset = 8 + (size_t)readBE32(ssnd);
+    size_t frameBytes = (size_t)rex.channels * (rex.bitDepth / 8);
+    if (audioOffset > ssndSize) return false;
+    rex.frames = (uint32_t)min((size_t)rex.frames, (ssndSize - audioOffset) / frameBytes);
+    rex.audio = ssnd + audioOffset;
+
+    rex.sliceOffsets.clear();
+    for (int i = 0; i < kRex1MaxSlices; i++) {
+        size_t entry = kRex1SliceTableOffset + (size_t)i * kRex1SliceEntrySize;
+        if (entry + 4 > rexSize) break;
+        uint32_t offset = readBE32(rexChunk + entry);
+        if (offset == 0 || find(rex.sliceOffsets.begin(), rex.sliceOffsets.end(), offset) != rex.sliceOffsets.end()) break;
+        rex.sliceOffsets.push_back(offset);
+    }
+    sort(rex.sliceOffsets.begin(), rex.sliceOffsets.end());
+    if (rex.sliceOffsets.empty()) return false;
+    corrupt = false;
+    return true;
+}
+
+// The audio that stays once the slice headers are cut out, as [start,
+// end) source frame ranges, and the slice table of the result. Returns
+// the length of the result in frames.
+uint32_t rex1KeptRanges(const Rex1File& rex, vector<pair<uint32_t, uint32_t>>& ranges, SliceTable& slices) {
+    vector<int32_t> markers;
+    uint32_t copied = 0; // frames before each range in the output
+    uint32_t readPos = 0;
+    auto keep = [&](uint32_t start, uint32_t end) {
+        start = max(start, readPos);
+        end = min(end, rex.frames);
+        if (start >= end) return;
+        ranges.push_back({ start, end });
+        copied += end - start;
+        readPos = end;
+    };
+    markers.push_back(1);
+    for (size_t i = 0; i < rex.sliceOffsets.size(); i++) {
+        uint32_t offset = rex.sliceOffsets[i];
+        // The header runs up to the offset, inclusive (1-based)
+        uint32_t headerStart = (offset >= (uint32_t)kRex1HeaderFrames) ? offset - kRex1HeaderFrames : 0;
+        if (i == 0) keep(0, headerStart);
+        readPos = max(readPos, offset);
+        int32_t marker = (int32_t)copied + 1;
+        if (marker > markers.back()) markers.push_back(marker);
+        uint32_t sliceEnd = (i + 1 < rex.sliceOffsets.size()) ? rex.sliceOffsets[i + 1] - min(rex.sliceOffsets[i + 1], (uint32_t)kRex1HeaderFrames)
+                                                             : rex.frames;
+        keep(offset, sliceEnd);
+    }
+    // A marker can't sit at or past the end of the audio
+    while (markers.size() > 1 && (uint32_t)markers.back() > copied) markers.pop_back();
+
+    slices.resize(markers.size());
+    for (size_t i = 0; i < markers.size(); i++) {
+        slices.ppqPos[i] = 0;
+        slices.frameStart[i] = markers[i];
+        slices.frameEnd[i] = (i + 1 < markers.size()) ? markers[i + 1] : (int32_t)copied;
+        slices.sampleLength[i] = slices.frameEnd[i] - slices.frameStart[i];
+    }
+    return copied;
+}
+
+// One PCM sample of the source as float in [-1, 1)
+inline float rex1Sample(const Rex1File& rex, const unsigned char* p) {
+    int32_t value;
+    switch (rex.bitDepth) {
+        case 8:  return (int8_t)p[0] / 128.0f;
+        case 16: value = rex.littleEndian ? (int16_t)(p[0] | (p[1] << 8)) : (int16_t)((p[0] << 8) | p[1]);
+                 return value / 32768.0f;
+        case 24: value = rex.littleEndian ? (p[0] | (p[1] << 8) | (p[2] << 16)) : ((p[0] << 16) | (p[1] << 8) | p[2]);
+                 value = (value ^ 0x800000) - 0x800000; // sign-extend
+                 return value / 8388608.0f;
+        default: value = rex.littleEndian ? (int32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24))
+                                          : (int32_t)readBE32(p);
+                 return (float)(value / 2147483648.0);
+    }
+}
+
+// Writes the kept ranges as a WAV. When the output format has the
+// source's bit depth the PCM is copied (byte-swapped) as is; otherwise it
+// goes through the float conversion and dither of the RX2 path.
+bool writeRex1Wav(const string& path, const Rex1File& rex, const vector<pair<uint32_t, uint32_t>>& ranges,
+                  uint32_t frames, SampleFormat format) {
+    int sourceBytes = rex.bitDepth / 8;
+    size_t sourceFrameBytes = (size_t)rex.channels * sourceBytes;
+    bool direct = (format == kFormatS16 && rex.bitDepth == 16) || (format == kFormatS24 && rex.bitDepth == 24);
+    if (direct) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) return false;
+        unsigned char header[44];
+        buildWavHeader(header, (int)frames, rex.channels, format, rex.sampleRate);
+        bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+        vector<unsigned char> block((size_t)kConvertBlockFrames * sourceFrameBytes);
+        for (const auto& range : ranges) {
+            for (uint32_t pos = range.first; ok && pos < range.second; ) {
+                uint32_t todo = min((uint32_t)kConvertBlockFrames, range.second - pos);
+                const unsigned char* in = rex.audio + (size_t)pos * sourceFrameBytes;
+                size_t bytes = (size_t)todo * sourceFrameBytes;
+                if (rex.littleEndian) {
+                    memcpy(block.data(), in, bytes);
+                } else {
+                    for (size_t b = 0; b < bytes; b += sourceBytes) {
+                        for (int k = 0; k < sourceBytes; k++) block[b + k] = in[b + sourceBytes - 1 - k];
+                    }
+                }
+                ok = fwrite(block.data(), 1, bytes, file) == bytes;
+                pos += todo;
+            }
+        }
+        statsAdd(&JobStats::outputBytes, sizeof(header) + (uint64_t)frames * sourceFrameBytes);
+        return (fclose(file) == 0) && ok;
+    }
+
+    StreamingWavWriter writer;
+    if (!writer.open(path, rex.channels, format, rex.sampleRate)) return false;
+    vector<float> blockSamples((size_t)rex.channels * kRenderBlockFrames);
+    float* buffers[2] = { blockSamples.data(), (rex.channels == 2) ? blockSamples.data() + kRenderBlockFrames : nullptr };
+    bool ok = true;
+    for (const auto& range : ranges) {
+        for (uint32_t pos = range.first; ok && pos < range.second; ) {
+            int todo = (int)min((uint32_t)kRenderBlockFrames, range.second - pos);
+            for (int f = 0; f < todo; f++) {
+                const unsigned char* in = rex.audio + (size_t)(pos + f) * sourceFrameBytes;
+                for (int c = 0; c < rex.channels; c++) buffers[c][f] = rex1Sample(rex, in + c * sourceBytes);
+            }
+            ok = writer.write(buffers, todo);
+            pos += (uint32_t)todo;
+        }
+    }
+    ok = writer.finish() && ok;
+    if (ok) statsAdd(&JobStats::outputBytes, 44 + (uint64_t)frames * rex.channels * sampleFormatBytes(format));
+    return ok;
+}
+
+// Decodes a REX1 job without the SDK. `handled` is false if the input
+// isn't a REX1 file (nothing is written then and the caller uses the SDK).
+// It never reads or writes the decode cache: entries hold SDK renders and
+// their key doesn't name the decode path.
+REX::REXError decodeRex1Job(const DecodeJob& job, ostream& log, REX::REXInfo* infoOut, bool& handled) {
+    handled = false;
+    StageTimer readTimer("read");
+    MappedFile file;
+    if (!file.open(job.rx2Path)) return REX::kREXError_NoError;
+    readTimer.stop();
+    Rex1File rex;
+    bool corrupt = false;
+    if (!parseRex1((const unsigned char*)file.data(), file.size(), rex, corrupt) && !corrupt) {
+        return REX::kREXError_NoError;
+    }
+    handled = true;
+    statsAdd(&JobStats::inputBytes, file.size());
+    if (corrupt) {
+        cerr << "Unsupported or damaged REX file: " << job.rx2Path << endl;
+        return REX::kREXError_FileCorrupt;
+    }
+
+    RenderedLoop loop;
+    vector<pair<uint32_t, uint32_t>> ranges;
+    loop.lengthFrames = (int)rex1KeptRanges(rex, ranges, loop.slices);
+    loop.latency = 0;
+    loop.tempo = 0;
+
+    REX::REXInfo info;
+    memset(&info, 0, sizeof(info));
+    info.fChannels = rex.channels;
+    info.fSampleRate = rex.sampleRate;
+    info.fSliceCount = (int)loop.slices.size();
+    info.fBitDepth = rex.bitDepth;
+    if (infoOut) *infoOut = info;
+    loop.format = resolveSampleFormat(info);
+    if (logSummary()) {
+        log << "Native REX1 parse: " << job.rx2Path << ", " << rex.channels << " channel(s), "
+            << rex.sampleRate << " Hz, " << rex.bitDepth << " bit, " << rex.sliceOffsets.size()
+            << " slice headers removed, " << loop.lengthFrames << " frames\n";
+    }
+
+    {
+        StageTimer writeTimer("write");
+        if (!writeRex1Wav(job.wavPath, rex, ranges, (uint32_t)loop.lengthFrames, loop.format)) {
+            cerr << "Failed to write output WAV file: " << job.wavPath << endl;
+            remove(job.wavPath.c_str());
+            return REX::kREXError_Undefined;
+        }
+    }
+    statsAdd(&JobStats::frames, loop.lengthFrames);
+    if (logSummary()) log << "Full loop written to: " << job.wavPath << " (" << sampleFormatName(loop.format) << ")\n";
+    {
+        StageTimer textTimer("text");
+        if (writeSliceText(job.txtPath, loop)) {
+            if (logSummary()) log << "Renoise slice commands written to: " << job.txtPath << "\n";
+        } else {
+            cerr << "Failed to open output text file: " << job.txtPath << endl;
+        }
+    }
+    if (!job.metaPath.empty()) {
+        StageTimer metaTimer("meta");
+        if (!writeJobMetadata(job, info, nullptr, loop)) {
+            cerr << "Failed to write metadata file: " << job.metaPath << endl;
+            return REX::kREXError_Undefined;
+        }
+        if (logSummary()) log << "Metadata written to: " << job.metaPath << "\n";
+    }
+    return REX::kREXError_NoError;
+}
+
+// One output set of a job: the loop at one tempo. Without a tempo list
+// (or with a single tempo) a job has one variant writing to the job's
+// own paths; with several, each variant's paths get a _<bpm>bpm suffix.
+struct DecodeVariant {
+    DecodeJob outputs;
+    int tempo;          // BPM * 1000, 0 = the file's tempo
+    string cacheKey;
+    bool done;
+};
+
+vector<DecodeVariant> jobVariants(const DecodeJob& job) {
+    vector<DecodeVariant> variants;
+    if (gRenderTempos.size() <= 1) {
+        variants.push_back({ job, gRenderTempos.empty() ? 0 : gRenderTempos[0], "", false });
+        return variants;
+    }
+    for (int tempo : gRenderTempos) {
+        DecodeJob outputs = job;
+        outputs.wavPath = tempoVariantPath(job.wavPath, tempo);
+        outputs.txtPath = tempoVariantPath(job.txtPath, tempo);
+        if (!job.metaPath.empty()) outputs.metaPath = tempoVariantPath(job.metaPath, tempo);
+        variants.push_back({ outputs, tempo, "", false });
+    }
+    return variants;
+}
+
+// Decode a single RX2 file. The REX library must already be initialized;
+// the handle is created and deleted here so batch runs reuse the same
+// library instance for every job. Progress output goes to `log`, which is
+// cout for a single run and a per-job buffer when jobs run in parallel.
+// All tempo variants are rendered from the one handle; variants found in
+// the decode cache are copied from there and never rendered.
+REX::REXError decodeJob(const DecodeJob& job, ostream& log, REX::REXInfo* infoOut = nullptr) {
+    // Before the cache lookup on purpose: see decodeRex1Job
+    if (gNativeRex && !gSliceMode && !gAnalyze && !gSnapZeroCrossing && !gTails && gRenderTempos.empty() && gOutputSampleRate == 0
+        && !gWriteOT && !gWriteXRNI) {
+        bool handled = false;
+        REX::REXError err = decodeRex1Job(job, log, infoOut, handled);
+        if (handled) return err;
+    }
+    vector<DecodeVariant> variants = jobVariants(job);
+    uint64_t fileHash = 0;
+    size_t pending = variants.size();
+    bool useCache = false;
+    if (!gCacheDir.empty()) {
+        StageTimer cacheTimer("cache");
+        useCache = hashRx2File(job.rx2Path, fileHash);
+        for (DecodeVariant& v : variants) {
+            if (!useCache) break;
+            v.cacheKey = decodeCacheKey(fileHash, v.tempo);
+            v.done = cacheFetch(v.cacheKey, v.outputs, log, infoOut);
+            if (v.done) pending--;
+        }
+    }
+    if (pending == 0) {
+        return REX::kREXError_NoError;
+    }
+
+    REX::REXHandle handle = nullptr;
+    REX::REXInfo info;
+    REX::REXError openErr = openRexHandle(job.rx2Path, handle, info, log);
+    if (openErr != REX::kREXError_NoError) {
+        return openErr;
+    }
+    if (infoOut) *infoOut = info;
+    
+    if (logSummary()) {
+        log << "=== Header Information ===\n";
+        log << "Channels:       " << info.fChannels << "\n";
+        // The rate the slice lengths below are in, like the metadata JSON
+        log << "Sample Rate:    " << outputSampleRate(info) << "\n";
+        log << "Slice Count:    " << info.fSliceCount << "\n";
+        double realTempo = info.fTempo / 1000.0;
+        double realOriginalTempo = info.fOriginalTempo / 1000.0;
+        log << "Tempo:          " << info.fTempo << " (Real BPM: " << realTempo << " BPM)\n";
+        log << "Original Tempo: " << info.fOriginalTempo << " (Real BPM: " << realOriginalTempo << " BPM)\n";
+        log << "Loop Length (PPQ):    " << info.fPPQLength << "\n";
+        log << "Time Signature:       " << info.fTimeSignNom << "/" << info.fTimeSignDenom << "\n";
+        log << "Bit Depth:      " << info.fBitDepth << "\n";
+        log << "==========================\n";
+    }
+
+    // Extract creator info
+    REX::REXCreatorInfo creator;
+    bool hasCreatorInfo = false;
+    if (logSummary() || !job.metaPath.empty() || useCache) {
+        REX::REXError creatorErr = sdkCall(REX::REXGetCreatorInfo, handle, sizeof(creator), &creator);
+        statsAdd(&JobStats::sdkCalls, 1);
+        hasCreatorInfo = (creatorErr == REX::kREXError_NoError);
+    }
+    if (logSummary()) {
+        if (hasCreatorInfo) {
+            log << "=== Creator Information ===\n";
+            log << "Name:       " << creator.fName << "\n";
+            log << "Copyright:  " << creator.fCopyright << "\n";
+            log << "URL:        " << creator.fURL << "\n";
+            log << "Email:      " << creator.fEmail << "\n";
+            log << "FreeText:   " << creator.fFreeText << "\n";
+            log << "===========================\n";
+        } else {
+            log << "No creator information available.\n";
+        }
+    }
+
+    // Fetch the slice table once; every output of every variant works from it
+    SliceTable sliceTable;
+    REX::REXError sliceErr = fetchSliceTable(handle, info.fSliceCount, sliceTable);
+    if (sliceErr != REX::kREXError_NoError) {
+        sdkCall(REX::REXDelete, &handle);
+        return sliceErr;
+    }
+    if (logDebug()) {
+        log << "=== Slice Information ===\n";
+        for (size_t i = 0; i < sliceTable.size(); i++) {
+            log << "Slice " << setfill('0') << setw(3) << (i+1) << setfill(' ')
+                 << ": PPQ Position = " << sliceTable.ppqPos[i]
+                 << ", Sample Length = " << sliceTable.sampleLength[i] << "\n";
+        }
+        log << "=========================\n";
+    }
+
+    // Render full loop using preview API (like REX Test App), once per variant
+    const REX::REXCreatorInfo* creatorPtr = hasCreatorInfo ? &creator : nullptr;
+    PreviewPool pool;
+    REX::REXError result = REX::kREXError_NoError;
+    for (DecodeVariant& v : variants) {
+        if (v.done) continue;
+        const DecodeJob& out = v.outputs;
+        RenderedLoop loop;
+        loop.slices = sliceTable;
+        REX::REXError renderErr = gSliceMode
+            ? renderSlices(handle, out.wavPath, out.txtPath, log, loop)
+            : previewRenderFullLoop(handle, out.wavPath, out.txtPath, log, loop, resolveTempo(info, v.tempo), pool);
+        if (renderErr != REX::kREXError_NoError) {
+            cerr << (gSliceMode ? "Slice render" : "Preview render") << " failed with error: " << renderErr << endl;
+        } else if (!out.metaPath.empty()) {
+            StageTimer metaTimer("meta");
+            if (writeJobMetadata(out, info, creatorPtr, loop)) {
+                if (logSummary()) log << "Metadata written to: " << out.metaPath << "\n";
+            } else {
+                cerr << "Failed to write metadata file: " << out.metaPath << endl;
+                renderErr = REX::kREXError_Undefined;
+            }
+        }
+        if (renderErr == REX::kREXError_NoError && !writeSamplerExports(out, info, loop, log)) {
+            renderErr = REX::kREXError_Undefined;
+        }
+        if (renderErr == REX::kREXError_NoError && !v.cacheKey.empty()) {
+            StageTimer cacheTimer("cache");
+            cacheStore(v.cacheKey, out, info, creatorPtr, loop, log);
+        }
+        if (renderErr != REX::kREXError_NoError && result == REX::kREXError_NoError) {
+            result = renderErr;
+        }
+    }
+
+    sdkCall(REX::REXDelete, &handle);
+    return result;
+}
+
+// Decodes one RX2 file into the framed stream described under "Stream
+// output", rendered at the first --tempo (the file's tempo by default).
+// streamName stands in for the WAV path in the log and the metadata.
+REX::REXError streamJob(const string& rx2Path, FILE* stream, const string& streamName, ostream& log) {
+    REX::REXHandle handle = nullptr;
+    REX::REXInfo info;
+    REX::REXError err = openRexHandle(rx2Path, handle, info, log);
+    if (err != REX::kREXError_NoError) {
+        return err;
+    }
+    REX::REXCreatorInfo creator;
+    bool hasCreatorInfo = sdkCall(REX::REXGetCreatorInfo, handle, sizeof(creator), &creator) == REX::kREXError_NoError;
+    statsAdd(&JobStats::sdkCalls, 1);
+
+    RenderedLoop loop;
+    err = fetchSliceTable(handle, info.fSliceCount, loop.slices);
+    if (err == REX::kREXError_NoError) {
+        unsigned char magic[8];
+        memcpy(magic, "RX2S", 4);
+        putLE32(magic + 4, kStreamVersion);
+        if (fwrite(magic, 1, sizeof(magic), stream) != sizeof(magic)) err = REX::kREXError_Undefined;
+    }
+    PreviewPool pool;
+    if (err == REX::kREXError_NoError) {
+        err = previewRenderFullLoop(handle, streamName, "", log, loop, renderTempo(info), pool, stream);
+        if (err != REX::kREXError_NoError) cerr << "Preview render failed with error: " << err << endl;
+    }
+    sdkCall(REX::REXDelete, &handle);
+    if (err != REX::kREXError_NoError) {
+        return err;
+    }
+
+    DecodeJob job = { rx2Path, streamName, "", "" };
+    bool ok = writeStreamChunk(stream, "TEXT", sliceText(loop))
+           && writeStreamChunk(stream, "META", jobMetadata(job, info, hasCreatorInfo ? &creator : nullptr, loop))
+           && writeStreamChunk(stream, "END ", "")
+           && fflush(stream) == 0;
+    if (!ok) {
+        cerr << "Failed to write output stream: " << streamName << endl;
+        return REX::kREXError_Undefined;
+    }
+    return REX::kREXError_NoError;
+}
+
+#if !defined(_WIN32)
+// Opens the output of a shm:NAME stream. Linux backs shared memory with
+// tmpfs files, so the stream is the segment itself (created or replaced)
+// and the decode lands in it as it renders. Elsewhere (macOS) a segment
+// can't grow after its first ftruncate, so the stream goes to a temp file
+// and closeSharedMemoryStream() moves it across once its size is known.
+// Neither way keeps a second copy of the output in memory.
+FILE* openSharedMemoryStream(const string& name) {
+#if defined(__linux__)
+    int fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    FILE* stream = fdopen(fd, "wb");
+    if (stream == nullptr) {
+        close(fd);
+        shm_unlink(name.c_str());
+    }
+    return stream;
+#else
+    (void)name;
+    return tmpfile();
+#endif
+}
+
+// Closes a stream from openSharedMemoryStream. With `ok` the segment ends
+// up holding exactly the `size` bytes written; otherwise, or if that
+// fails, the segment is removed.
+bool closeSharedMemoryStream(const string& name, FILE* stream, bool ok, size_t& size) {
+    ok = (fflush(stream) == 0) && ok;
+    off_t end = ftello(stream);
+    ok = ok && end >= 0;
+    size = ok ? (size_t)end : 0;
+#if !defined(__linux__)
+    if (ok) {
+        int fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+        ok = (fd >= 0) && ftruncate(fd, end) == 0;
+        if (ok && size > 0) {
+            void* segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ok = (segment != MAP_FAILED);
+            if (ok) {
+                rewind(stream);
+                ok = fread(segment, 1, size, stream) == size;
+                munmap(segment, size);
+            }
+        }
+        if (fd >= 0) close(fd);
+    }
+#endif
+    fclose(stream);
+    if (!ok) shm_unlink(name.c_str());
+    return ok;
+}
+#endif
+
+// --stream: one decode, written to stdout or into a shared memory segment
+// as it renders (see openSharedMemoryStream). A finished segment is
+// announced on stdout as
+//   STREAM<TAB>/name<TAB>size in bytes
+// and belongs to the reader from then on (it calls shm_unlink).
+int runStream(const string& rx2Path) {
+    ostringstream jobLog;
+    REX::REXError err;
+    if (gStreamTarget == kStreamStdout) {
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        err = withJobStats(rx2Path, [&]() { return streamJob(rx2Path, stdout, "stdout", jobLog); });
+        cout << jobLog.str();
+        return (err == REX::kREXError_NoError) ? 0 : 1;
+    }
+#if defined(_WIN32)
+    cerr << "Shared memory streams need a POSIX build" << endl;
+    return 1;
+#else
+    FILE* segment = openSharedMemoryStream(gStreamShmName);
+    if (segment == nullptr) {
+        cerr << "Failed to create shared memory segment: " << gStreamShmName << endl;
+        return 1;
+    }
+    err = withJobStats(rx2Path, [&]() { return streamJob(rx2Path, segment, "shm:" + gStreamShmName, jobLog); });
+    size_t size = 0;
+    bool ok = closeSharedMemoryStream(gStreamShmName, segment, err == REX::kREXError_NoError, size);
+    if (!ok && err == REX::kREXError_NoError) {
+        cerr << "Failed to create shared memory segment: " << gStreamShmName << endl;
+    }
+    cout << jobLog.str();
+    if (ok) cout << "STREAM\t" << gStreamShmName << "\t" << size << endl;
+    return ok ? 0 : 1;
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Render batch benchmark: throughput and output identity per batch size
+// ---------------------------------------------------------------------
+// Renders the full preview loop once per batch size (best of `rounds`),
+// prints one BENCH line per size and checks that every size produces the
+// same samples as the first one:
+//   BENCH<TAB>batch<TAB>sdk calls<TAB>ms<TAB>frames/s<TAB>checksum<TAB>same|DIFFERENT
+// Returns non-zero if any size failed or rendered different samples.
+int runRenderBatchBenchmark(const string& rx2Path, const vector<int>& batchSizes, int rounds) {
+    REX::REXHandle handle = nullptr;
+    REX::REXInfo info;
+    REX::REXError err = openRexHandle(rx2Path, handle, info, cout);
+    if (err != REX::kREXError_NoError) {
+        return 1;
+    }
+    err = sdkCall(REX::REXSetPreviewTempo, handle, renderTempo(info));
+    if (err != REX::kREXError_NoError) {
+        cerr << "REXSetPreviewTempo failed: " << err << endl;
+        sdkCall(REX::REXDelete, &handle);
+        return 1;
+    }
+
+    int lengthFrames = previewLengthFrames(info, renderTempo(info));
+    vector<float> blockSamples((size_t)info.fChannels * kRenderBlockFrames);
+    float* renderBuffers[2] = { blockSamples.data(), (info.fChannels == 2) ? blockSamples.data() + kRenderBlockFrames : nullptr };
+    cout << "Benchmarking " << rx2Path << ": " << lengthFrames << " frames, "
+         << info.fChannels << " channel(s), best of " << rounds << endl;
+
+    uint64_t referenceChecksum = 0;
+    int exitCode = 0;
+    for (size_t n = 0; n < batchSizes.size(); n++) {
+        double bestMs = -1.0;
+        int calls = 0;
+        uint64_t checksum = 0;
+        for (int round = 0; round < rounds && err == REX::kREXError_NoError; round++) {
+            int batchFrames = batchSizes[n];
+            calls = 0;
+            // FNV-1a over the raw float bits of every rendered sample
+            checksum = 1469598103934665603ULL;
+            auto start = chrono::steady_clock::now();
+            err = sdkCall(REX::REXStartPreview, handle);
+            for (int done = 0; err == REX::kREXError_NoError && done < lengthFrames; ) {
+                int blockFrames = min(kRenderBlockFrames, lengthFrames - done);
+                err = renderPreviewFrames(handle, renderBuffers, 0, blockFrames, batchFrames, &calls);
+                for (int c = 0; c < info.fChannels && err == REX::kREXError_NoError; c++) {
+                    const unsigned char* bytes = (const unsigned char*)renderBuffers[c];
+                    for (size_t b = 0; b < (size_t)blockFrames * sizeof(float); b++) {
+                        checksum = (checksum ^ bytes[b]) * 1099511628211ULL;
+                    }
+                }
+                done += blockFrames;
+            }
+            sdkCall(REX::REXStopPreview, handle);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (bestMs < 0.0 || ms < bestMs) bestMs = ms;
+        }
+        if (err != REX::kREXError_NoError) {
+            cerr << "Batch size " << batchSizes[n] << " failed with error: " << err << endl;
+            exitCode = 1;
+            err = REX::kREXError_NoError;
+            continue;
+        }
+        if (n == 0) referenceChecksum = checksum;
+        bool same = (checksum == referenceChecksum);
+        if (!same) exitCode = 1;
+        double framesPerSecond = (bestMs > 0.0) ? lengthFrames / (bestMs / 1000.0) : 0.0;
+        cout << "BENCH\t" << batchSizes[n] << "\t" << calls << "\t" << fixed << setprecision(3) << bestMs
+             << "\t" << setprecision(0) << framesPerSecond << "\t" << hex << checksum << dec
+             << "\t" << (same ? "same" : "DIFFERENT") << endl;
+    }
+    sdkCall(REX::REXDelete, &handle);
+    return exitCode;
+}
+
+// "64,256,4096" -> {64, 256, 4096}
+bool parseBatchSizes(const string& text, vector<int>& sizes) {
+    stringstream list(text);
+    string item;
+    while (getline(list, item, ',')) {
+        int size = atoi(item.c_str());
+        if (size <= 0) return false;
+        sizes.push_back(size);
+    }
+    return !sizes.empty();
+}
+
+// ---------------------------------------------------------------------
+// Batch mode: one REXInitializeDLL_DirPath for many jobs
+// ---------------------------------------------------------------------
+// Each manifest line holds one job as three or four TAB-separated fields:
+//   input.rx2<TAB>output.wav<TAB>output.txt[<TAB>metadata]
+// Blank lines and lines starting with '#' are ignored. Tabs are used so
+// that paths may contain spaces.
+bool parseJobLine(const string& line, DecodeJob& job) {
+    size_t first = line.find('\t');
+    if (first == string::npos) return false;
+    size_t second = line.find('\t', first + 1);
+    if (second == string::npos) return false;
+    job.rx2Path = line.substr(0, first);
+    job.wavPath = line.substr(first + 1, second - first - 1);
+    size_t third = line.find('\t', second + 1);
+    if (third == string::npos) {
+        job.txtPath = line.substr(second + 1);
+        job.metaPath.clear();
+    } else {
+        job.txtPath = line.substr(second + 1, third - second - 1);
+        job.metaPath = line.substr(third + 1);
+    }
+    // Tolerate CRLF manifests written on Windows
+    string& last = job.metaPath.empty() ? job.txtPath : job.metaPath;
+    if (!last.empty() && last.back() == '\r') last.pop_back();
+    return !job.rx2Path.empty() && !job.wavPath.empty() && !job.txtPath.empty();
+}
+
+// Batch jobs as read from the manifest. Malformed lines are kept (with
+// `valid` false) so that job numbering matches the manifest order.
+struct BatchEntry {
+    DecodeJob job;
+    string line;
+    bool valid;
+};
+
+struct JobResult {
+    REX::REXError err = REX::kREXError_NoError;
+    string log;
+    bool done = false;
+};
+
+bool readManifest(const string& manifestPath, vector<BatchEntry>& entries) {
+    ifstream manifestFile;
+    istream* in = &cin;
+    if (manifestPath != "-") {
+        manifestFile.open(manifestPath);
+        if (!manifestFile) {
+            cerr << "Failed to open batch manifest: " << manifestPath << endl;
+            return false;
+        }
+        in = &manifestFile;
+    }
+    string line;
+    while (getline(*in, line)) {
+        if (line.empty() || line[0] == '#' || line == "\r") continue;
+        BatchEntry entry;
+        entry.line = line;
+        entry.valid = parseJobLine(line, entry.job);
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+REX::REXError runEntry(const BatchEntry& entry, size_t jobIndex, ostream& log) {
+    if (!entry.valid) {
+        cerr << "Malformed batch line " << jobIndex << ": " << entry.line << endl;
+        return REX::kREXError_Undefined;
+    }
+    return withJobStats(entry.job.rx2Path, [&]() { return decodeJob(entry.job, log); });
+}
+
+void printJobStatus(const BatchEntry& entry, size_t jobIndex, REX::REXError err) {
+    cout << "JOB\t" << jobIndex << "\t" << (err == REX::kREXError_NoError ? "OK" : "FAIL")
+         << "\t" << err << "\t" << (entry.valid ? entry.job.rx2Path : entry.line) << endl;
+}
+
+// Runs work(i, log) for i in [0, count) on `workerCount` threads and
+// calls emit(i, result) for each of them in index order as soon as it
+// and all earlier ones are done. With one worker everything runs on the
+// calling thread.
+template <typename Work, typename Emit>
+void runOrdered(size_t count, int workerCount, Work work, Emit emit) {
+    if (workerCount <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            ostringstream jobLog;
+            JobResult result;
+            result.err = work(i, jobLog);
+            result.log = jobLog.str();
+            result.done = true;
+            emit(i, result);
+        }
+        return;
+    }
+    if ((size_t)workerCount > count) workerCount = (int)count;
+
+    vector<JobResult> results(count);
+    atomic<size_t> nextJob(0);
+    mutex resultsMutex;
+    condition_variable resultReady;
+
+    vector<thread> workers;
+    for (int w = 0; w < workerCount; w++) {
+        workers.emplace_back([&]() {
+            for (;;) {
+                size_t i = nextJob++;
+                if (i >= count) break;
+                ostringstream jobLog;
+                REX::REXError err = work(i, jobLog);
+                lock_guard<mutex> lock(resultsMutex);
+                results[i].err = err;
+                results[i].log = jobLog.str();
+                results[i].done = true;
+                resultReady.notify_all();
+            }
+        });
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        unique_lock<mutex> lock(resultsMutex);
+        resultReady.wait(lock, [&]() { return results[i].done; });
+        JobResult result = std::move(results[i]);
+        lock.unlock();
+        emit(i, result);
+    }
+    for (thread& worker : workers) worker.join();
+}
+
+// Reads jobs from the manifest (or stdin when manifestPath is "-") and
+// decodes them on `workerCount` threads, each with its own REX handle and
+// render buffers; their SDK calls take turns (sdkCall). A status line is printed per job, always in manifest
+// order regardless of which worker finishes first:
+//   JOB<TAB>index<TAB>OK|FAIL<TAB>error code<TAB>input path
+// Returns the number of failed jobs, or -1 if the manifest can't be read.
+int runBatch(const string& manifestPath, int workerCount) {
+    vector<BatchEntry> entries;
+    if (!readManifest(manifestPath, entries)) {
+        return -1;
+    }
+
+    int failed = 0;
+    if (workerCount > 1 && entries.size() > 1 && logSummary()) {
+        cout << "Decoding " << entries.size() << " jobs on " << min((size_t)workerCount, entries.size()) << " workers\n";
+    }
+    // Flush job logs and status lines in manifest order as they complete
+    runOrdered(entries.size(), workerCount,
+        [&](size_t i, ostream& log) { return runEntry(entries[i], i + 1, log); },
+        [&](size_t i, const JobResult& result) {
+            cout << result.log;
+            printJobStatus(entries[i], i + 1, result.err);
+            if (result.err != REX::kREXError_NoError) failed++;
+        });
+    cout << "BATCH\t" << entries.size() << " jobs\t" << failed << " failed" << endl;
+    return failed;
+}
+
+// ---------------------------------------------------------------------
+// Probe mode: header, creator and slice table only, for library indexing
+// ---------------------------------------------------------------------
+// Each argument is an RX2/REX/RCY file, a directory (walked recursively
+// for those extensions, in sorted order) or "-" for a list of paths on
+// stdin, one per line. Files are probed on --jobs workers; nothing is
+// rendered or written. One JSON object per file goes to stdout, in input
+// order, on a single line:
+//   {"input": ..., "status": "OK", "error": 0, "channels": ..., "sampleRate": ...,
+//    "bitDepth": ..., "tempo": ..., "originalTempo": ..., "ppqLength": ...,
+//    "timeSignature": [n, d], "sliceCount": ..., "lengthFrames": ...,
+//    "creator": {...} | null, "slices": [[ppq, sampleLength], ...]}
+// lengthFrames is what a decode would render (at --sample-rate/--tempo
+// when given). A failed file gets only input, status "FAIL" and error.
+bool isRexFile(const fs::path& path) {
+    string extension = path.extension().u8string();
+    transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return extension == ".rx2" || extension == ".rex" || extension == ".rcy";
+}
+
+// Expands the probe arguments into a list of files. Unreadable
+// directories are reported and skipped.
+void collectProbePaths(const vector<string>& args, vector<string>& paths) {
+    for (const string& arg : args) {
+        if (arg == "-") {
+            string line;
+            while (getline(cin, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) paths.push_back(line);
+            }
+            continue;
+        }
+        error_code ec;
+        fs::path root = cacheFsPath(arg);
+        if (!fs::is_directory(root, ec)) {
+            paths.push_back(arg);
+            continue;
+        }
+        vector<string> found;
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && isRexFile(it->path())) found.push_back(it->path().u8string());
+        }
+        if (ec) cerr << "Failed to walk directory: " << arg << " (" << ec.message() << ")" << endl;
+        sort(found.begin(), found.end());
+        paths.insert(paths.end(), found.begin(), found.end());
+    }
+}
+
+REX::REXError probeFile(const string& rx2Path, string& record, ostream& log) {
+    ostringstream json;
+    json << "{\"input\": \"" << jsonEscape(rx2Path.c_str()) << "\", ";
+    REX::REXHandle handle = nullptr;
+    REX::REXInfo info;
+    REX::REXError err = openRexHandle(rx2Path, handle, info, log);
+    SliceTable slices;
+    if (err == REX::kREXError_NoError) {
+        err = fetchSliceTable(handle, info.fSliceCount, slices);
+    }
+    if (err != REX::kREXError_NoError) {
+        if (handle) sdkCall(REX::REXDelete, &handle);
+        json << "\"status\": \"FAIL\", \"error\": " << err << "}";
+        record = json.str();
+        return err;
+    }
+    REX::REXCreatorInfo creator;
+    bool hasCreatorInfo = sdkCall(REX::REXGetCreatorInfo, handle, sizeof(creator), &creator) == REX::kREXError_NoError;
+    statsAdd(&JobStats::sdkCalls, 1);
+    sdkCall(REX::REXDelete, &handle);
+
+    // lengthFrames and the slice lengths are at the handle's output rate,
+    // so that is the rate reported, as in the metadata JSON
+    json << "\"status\": \"OK\", \"error\": 0"
+         << ", \"channels\": " << info.fChannels
+         << ", \"sampleRate\": " << outputSampleRate(info)
+         << ", \"bitDepth\": " << info.fBitDepth
+         << ", \"tempo\": " << info.fTempo
+         << ", \"originalTempo\": " << info.fOriginalTempo
+         << ", \"ppqLength\": " << info.fPPQLength
+         << ", \"timeSignature\": [" << info.fTimeSignNom << ", " << info.fTimeSignDenom << "]"
+         << ", \"sliceCount\": " << info.fSliceCount
+         << ", \"lengthFrames\": " << previewLengthFrames(info, renderTempo(info));
+    if (hasCreatorInfo) {
+        json << ", \"creator\": {\"name\": \"" << jsonEscape(creator.fName)
+             << "\", \"copyright\": \"" << jsonEscape(creator.fCopyright)
+             << "\", \"url\": \"" << jsonEscape(creator.fURL)
+             << "\", \"email\": \"" << jsonEscape(creator.fEmail)
+             << "\", \"freeText\": \"" << jsonEscape(creator.fFreeText) << "\"}";
+    } else {
+        json << ", \"creator\": null";
+    }
+    json << ", \"slices\": [";
+    for (size_t i = 0; i < slices.size(); i++) {
+        json << (i == 0 ? "[" : ", [") << slices.ppqPos[i] << ", " << slices.sampleLength[i] << "]";
+    }
+    json << "]}";
+    record = json.str();
+    return REX::kREXError_NoError;
+}
+
+// Writes the records to `out`. Returns the number of files that failed
+// to probe, or -1 if there was nothing to probe.
+int runProbe(const vector<string>& args, int workerCount, ostream& out) {
+    vector<string> paths;
+    collectProbePaths(args, paths);
+    if (paths.empty()) {
+        cerr << "No RX2 files to probe" << endl;
+        return -1;
+    }
+    vector<string> records(paths.size());
+    int failed = 0;
+    runOrdered(paths.size(), workerCount,
+        [&](size_t i, ostream& log) {
+            return withJobStats(paths[i], [&]() { return probeFile(paths[i], records[i], log); });
+        },
+        [&](size_t i, const JobResult& result) {
+            cout << result.log;
+            out << records[i] << "\n";
+            if (result.err != REX::kREXError_NoError) failed++;
+        });
+    out << flush;
+    if (logSummary()) cout << "Probed " << paths.size() << " files, " << failed << " failed" << endl;
+    return failed;
+}
+
+// ---------------------------------------------------------------------
+// Server mode: keep the REX library loaded and decode on request
+// ---------------------------------------------------------------------
+// The endpoint is either "tcp:PORT" (bound to 127.0.0.1, reachable from
+// renoise.Socket) or, on POSIX builds, "unix:/path/to/socket" for a Unix
+// domain socket.
+//
+// Every message in both directions is one frame: a 4-byte little-endian
+// payload length followed by the payload. A request payload is a job
+// line in the same TAB-separated format as the batch manifest, or one of
+// the commands PING and QUIT. A response payload is a list of
+// "key<TAB>value" lines, starting with "status<TAB>OK|FAIL".
+#if defined(_WIN32)
+typedef SOCKET socket_t;
+const socket_t kInvalidSocket = INVALID_SOCKET;
+#else
+typedef int socket_t;
+const socket_t kInvalidSocket = -1;
+#endif
+const uint32_t kMaxFrameSize = 1024 * 1024;
+#if defined(_WIN32)
+const char* const kServeEndpoints = "tcp:PORT";
+#else
+const char* const kServeEndpoints = "tcp:PORT or unix:/path";
+#endif
+
+void close_socket(socket_t s) {
+#if defined(_WIN32)
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool sendAll(socket_t s, const char* data, size_t size) {
+    while (size > 0) {
+        int sent = send(s, data, (int)size, 0);
+        if (sent <= 0) return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+bool recvAll(socket_t s, char* data, size_t size) {
+    while (size > 0) {
+        int received = recv(s, data, (int)size, 0);
+        if (received <= 0) return false;
+        data += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+bool readFrame(socket_t s, string& payload) {
+    unsigned char header[4];
+    if (!recvAll(s, (char*)header, sizeof(header))) return false;
+    uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+    if (size > kMaxFrameSize) {
+        cerr << "Rejecting oversized request frame: " << size << " bytes" << endl;
+        return false;
+    }
+    payload.resize(size);
+    return size == 0 || recvAll(s, &payload[0], size);
+}
+
+bool writeFrame(socket_t s, const string& payload) {
+    uint32_t size = (uint32_t)payload.size();
+    unsigned char header[4] = {
+        (unsigned char)(size & 0xFF), (unsigned char)((size >> 8) & 0xFF),
+        (unsigned char)((size >> 16) & 0xFF), (unsigned char)((size >> 24) & 0xFF)
+    };
+    return sendAll(s, (const char*)header, sizeof(header)) && sendAll(s, payload.data(), payload.size());
+}
+
+socket_t openListener(const string& endpoint) {
+    socket_t listener = kInvalidSocket;
+    if (endpoint.compare(0, 4, "tcp:") == 0) {
+        int port = atoi(endpoint.c_str() + 4);
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener == kInvalidSocket) return kInvalidSocket;
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close_socket(listener);
+            return kInvalidSocket;
+        }
+#if !defined(_WIN32)
+    } else if (endpoint.compare(0, 5, "unix:") == 0) {
+        string socketPath = endpoint.substr(5);
+        sockaddr_un addr;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            cerr << "Socket path too long: " << socketPath << endl;
+            return kInvalidSocket;
+        }
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener == kInvalidSocket) return kInvalidSocket;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socketPath.c_str()); // stale socket from a previous run
+        if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close_socket(listener);
+            return kInvalidSocket;
+        }
+#endif
+    } else {
+        cerr << "Unknown server endpoint (use " << kServeEndpoints << "): " << endpoint << endl;
+        return kInvalidSocket;
+    }
+    if (listen(listener, 8) != 0) {
+        close_socket(listener);
+        return kInvalidSocket;
+    }
+    return listener;
+}
+
+// Decodes one request and builds the response payload.
+string handleRequest(const string& payload, bool& quit) {
+    ostringstream response;
+    string request = payload;
+    while (!request.empty() && (request.back() == '\n' || request.back() == '\r')) request.pop_back();
+
+    if (request == "PING") {
+        response << "status\tOK\n";
+        return response.str();
+    }
+    if (request == "QUIT") {
+        quit = true;
+        response << "status\tOK\n";
+        return response.str();
+    }
+
+    DecodeJob job;
+    if (!parseJobLine(request, job)) {
+        response << "status\tFAIL\n" << "error\t" << REX::kREXError_Undefined << "\n"
+                 << "message\tmalformed request\n";
+        return response.str();
+    }
+
+    REX::REXInfo info;
+    memset(&info, 0, sizeof(info));
+    ostringstream jobLog;
+    REX::REXError err = withJobStats(job.rx2Path, [&]() { return decodeJob(job, jobLog, &info); });
+    cout << jobLog.str() << flush;
+    response << "status\t" << (err == REX::kREXError_NoError ? "OK" : "FAIL") << "\n";
+    response << "error\t" << err << "\n";
+    response << "input\t" << job.rx2Path << "\n";
+    response << "wav\t" << job.wavPath << "\n";
+    response << "txt\t" << job.txtPath << "\n";
+    if (!job.metaPath.empty()) response << "meta\t" << job.metaPath << "\n";
+    if (info.fSampleRate != 0) {
+        response << "channels\t" << info.fChannels << "\n";
+        response << "sampleRate\t" << outputSampleRate(info) << "\n";
+        response << "sliceCount\t" << info.fSliceCount << "\n";
+        response << "tempo\t" << info.fTempo << "\n";
+        response << "originalTempo\t" << info.fOriginalTempo << "\n";
+        response << "ppqLength\t" << info.fPPQLength << "\n";
+        response << "timeSignature\t" << info.fTimeSignNom << "/" << info.fTimeSignDenom << "\n";
+        response << "bitDepth\t" << info.fBitDepth << "\n";
+    }
+    return response.str();
+}
+
+// Accepts one client at a time and answers its requests until it
+// disconnects. Runs until a client sends QUIT.
+int runServer(const string& endpoint) {
+#if defined(_WIN32)
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        cerr << "WSAStartup failed" << endl;
+        return 1;
+    }
+#else
+    signal(SIGPIPE, SIG_IGN); // a client hanging up must not kill the server
+#endif
+    socket_t listener = openListener(endpoint);
+    if (listener == kInvalidSocket) {
+        cerr << "Failed to listen on: " << endpoint << endl;
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return 1;
+    }
+    cout << "Listening on " << endpoint << endl;
+
+    bool quit = false;
+    while (!quit) {
+        socket_t client = accept(listener, nullptr, nullptr);
+        if (client == kInvalidSocket) {
+            cerr << "accept() failed" << endl;
+            break;
+        }
+        string payload;
+        while (!quit && readFrame(client, payload)) {
+            if (!writeFrame(client, handleRequest(payload, quit))) break;
+        }
+        close_socket(client);
+    }
+    close_socket(listener);
+#if defined(_WIN32)
+    WSACleanup();
+#else
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        unlink(endpoint.substr(5).c_str());
+    }
+#endif
+    return quit ? 0 : 1;
+}
+
+void print_usage(const char* argv0) {
+    cerr << "Usage: " << argv0 << " input.rx2 output.wav output.txt sdk_path" << endl;
+    cerr << "       " << argv0 << " --batch manifest.txt|- [--jobs N] sdk_path" << endl;
+    cerr << "       " << argv0 << " --serve ENDPOINT sdk_path" << endl;
+    cerr << "       " << argv0 << " --stream TARGET input.rx2 sdk_path" << endl;
+    cerr << "       " << argv0 << " --probe [--jobs N] file|directory|- ... sdk_path" << endl;
+    cerr << "       " << argv0 << " --bench-batch 64,256,4096 input.rx2 sdk_path" << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --batch FILE   decode TAB-separated jobs from FILE ('-' for stdin)" << endl;
+    cerr << "  --jobs N       decode N batch jobs (or probe N files) in parallel (0 = one per core)" << endl;
+    cerr << "  --probe        print header, creator and slice table as one JSON line per file; no render" << endl;
+    cerr << "  --verbosity L  silent (default), summary or debug" << endl;
+    cerr << "  --slices       write one WAV per slice (output_001.wav, ...) instead of the loop" << endl;
+    cerr << "  --native-rex   decode legacy REX1 (.rex AIFF) loops without the SDK; loop mode at the file's" << endl;
+    cerr << "                 own tempo and rate only, without --ot/--xrni; other inputs and jobs still use the SDK" << endl;
+    cerr << "  --format F     s16, s24 or f32 (default: the REX file's bit depth)" << endl;
+    cerr << "  --dither D     tpdf (default) or none, for s16/s24 output" << endl;
+    cerr << "  --sample-rate R  render at R Hz instead of the file's rate" << endl;
+    cerr << "  --tempo L      render the loop at BPM (or a list like 90,120,174: one output set" << endl;
+    cerr << "                 per tempo, suffixed _90bpm etc.) instead of the file's tempo; not with --slices" << endl;
+    cerr << "  --latency L    marker latency compensation: frames (default " << PREVIEW_LATENCY_COMPENSATION
+         << "), auto (measured per file) or auto-slice (per slice)" << endl;
+    cerr << "  --snap S       zero-crossing[:N]: move loop markers to the nearest frame within N (default "
+         << kDefaultSnapFrames << ")" << endl;
+    cerr << "                 where all channels cross zero; the metadata keeps the original starts" << endl;
+    cerr << "  --tails T      report each slice's and the loop's length without its silent tail;" << endl;
+    cerr << "                 T = threshold dBFS[:hold ms[:fade ms]] (default -60:10:5)" << endl;
+    cerr << "  --trim         write slices cut to their effective length, or a loop with the slice tails" << endl;
+    cerr << "                 cut out (implies --tails; the loop no longer matches its tempo)" << endl;
+    cerr << "  --analyze      add peak, true peak, RMS and loudness of the loop and each slice to the metadata" << endl;
+    cerr << "  --normalize T  scale the output to T before writing: peak:DBTP (true peak) or lufs:LUFS;" << endl;
+    cerr << "                 a loop goes through a float temp file; normalizes each slice with --slices (implies --analyze)" << endl;
+    cerr << "  --render-batch N  frames per REXRenderPreviewBatch call (default: 64, as in the REX Test App)" << endl;
+    cerr << "  --bench-batch L   time the preview render for each batch size in L" << endl;
+    cerr << "  --ot           also write an Octatrack .ot (slices, tempo) next to each loop WAV" << endl;
+    cerr << "  --xrni         also write a sliced Renoise instrument (.xrni) next to each loop WAV" << endl;
+    cerr << "  --meta FILE    also write header, creator and slice table metadata" << endl;
+    cerr << "  --meta-format F  json (default) or binary; batch jobs take FILE as a 4th field" << endl;
+    cerr << "  --stats FILE   append per-job stage timings and counters as JSON lines ('-' for stderr)" << endl;
+    cerr << "  --trace FILE   write all job and stage spans as a Chrome trace-event file" << endl;
+    cerr << "  --cache DIR    reuse earlier decodes of the same file and options from DIR" << endl;
+    cerr << "  --cache-limit MB  evict least recently used cache entries above MB (default 1024)" << endl;
+    cerr << "  --serve EP     stay resident and decode requests on EP (" << kServeEndpoints << ")" << endl;
+    cerr << "  --stream T     write WAV, slice text and metadata as one framed stream to T: stdout"
+#if !defined(_WIN32)
+         << " or shm:NAME (a shared memory segment)"
+#endif
+         << endl;
+}
+
+// "90,120,174.5" -> BPM * 1000 each; rejects duplicates, whose outputs
+// would collide.
+bool parseTempoList(const string& text, vector<int>& tempos) {
+    tempos.clear();
+    stringstream list(text);
+    string item;
+    while (getline(list, item, ',')) {
+        char* end = nullptr;
+        double bpm = strtod(item.c_str(), &end);
+        if (end == item.c_str() || *end != '\0' || bpm <= 0.0) return false;
+        int tempo = (int)lround(bpm * 1000.0);
+        if (find(tempos.begin(), tempos.end(), tempo) != tempos.end()) return false;
+        tempos.push_back(tempo);
+    }
+    return !tempos.empty();
+}
+
+// "-60", "-60:10" or "-60:10:5": threshold dBFS, then hold and fade in ms;
+// omitted fields keep their defaults.
+bool parseTailSpec(const string& text) {
+    double values[3] = { gTailThresholdDb, gTailHoldMs, gTailFadeMs };
+    stringstream spec(text);
+    string item;
+    int count = 0;
+    while (getline(spec, item, ':')) {
+        char* end = nullptr;
+        if (count == 3) return false;
+        values[count++] = strtod(item.c_str(), &end);
+        if (end == item.c_str() || *end != '\0') return false;
+    }
+    if (count == 0 || values[1] < 0.0 || values[2] < 0.0) return false;
+    gTailThresholdDb = values[0];
+    gTailHoldMs = values[1];
+    gTailFadeMs = values[2];
+    return true;
+}
+
+// Command line options; anything not starting with "--" is positional.
+struct Options {
+    string batchManifest;
+    string serveEndpoint;
+    string metaPath;
+    vector<int> benchBatchSizes;
+    bool probe = false;
+    int jobs = 1;
+    vector<string> positional;
+};
+
+bool parseOptions(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            opts.positional.push_back(arg);
+            continue;
+        }
+        if (arg == "--slices") {
+            gSliceMode = true;
+            continue;
+        }
+        if (arg == "--probe") {
+            opts.probe = true;
+            continue;
+        }
+        if (arg == "--native-rex") {
+            gNativeRex = true;
+            continue;
+        }
+        if (arg == "--analyze") {
+            gAnalyze = true;
+            continue;
+        }
+        if (arg == "--trim") {
+            gTrim = true;
+            gTails = true;
+            continue;
+        }
+        if (arg == "--ot" || arg == "--xrni") {
+            (arg == "--ot" ? gWriteOT : gWriteXRNI) = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return false;
+        }
+        string value = argv[++i];
+        if (arg == "--batch") {
+            opts.batchManifest = value;
+        } else if (arg == "--serve") {
+            opts.serveEndpoint = value;
+        } else if (arg == "--stream") {
+            if (value == "stdout") {
+                gStreamTarget = kStreamStdout;
+#if !defined(_WIN32)
+            } else if (value.compare(0, 4, "shm:") == 0 && value.size() > 4) {
+                gStreamTarget = kStreamShm;
+                gStreamShmName = (value[4] == '/') ? value.substr(4) : "/" + value.substr(4);
+#endif
+            } else {
+                cerr << "Unknown stream target: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--meta") {
+            opts.metaPath = value;
+        } else if (arg == "--cache") {
+            gCacheDir = value;
+        } else if (arg == "--stats") {
+            gStatsPath = value;
+            gStatsEnabled = true;
+        } else if (arg == "--trace") {
+            gTracePath = value;
+            gStatsEnabled = true;
+        } else if (arg == "--cache-limit") {
+            long long megabytes = atoll(value.c_str());
+            if (megabytes <= 0) {
+                cerr << "Invalid cache limit: " << value << endl;
+                return false;
+            }
+            gCacheLimitBytes = (uint64_t)megabytes * 1024 * 1024;
+        } else if (arg == "--meta-format") {
+            if (value == "json") gMetaFormat = kMetaJSON;
+            else if (value == "binary") gMetaFormat = kMetaBinary;
+            else {
+                cerr << "Unknown metadata format: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--render-batch") {
+            gRenderBatchFrames = atoi(value.c_str());
+            if (gRenderBatchFrames < 1) {
+                cerr << "Invalid render batch size: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--bench-batch") {
+            if (!parseBatchSizes(value, opts.benchBatchSizes)) {
+                cerr << "Invalid batch size list: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--format") {
+            if (value == "s16") gSampleFormat = kFormatS16;
+            else if (value == "s24") gSampleFormat = kFormatS24;
+            else if (value == "f32") gSampleFormat = kFormatF32;
+            else {
+                cerr << "Unknown sample format: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--dither") {
+            if (value == "tpdf") gDither = true;
+            else if (value == "none") gDither = false;
+            else {
+                cerr << "Unknown dither mode: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--sample-rate") {
+            gOutputSampleRate = atoi(value.c_str());
+            if (gOutputSampleRate <= 0) {
+                cerr << "Invalid sample rate: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--tempo") {
+            if (!parseTempoList(value, gRenderTempos)) {
+                cerr << "Invalid tempo list: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--normalize") {
+            size_t colon = value.find(':');
+            string mode = value.substr(0, colon);
+            char* end = nullptr;
+            const char* target = (colon == string::npos) ? "" : value.c_str() + colon + 1;
+            gNormalizeTarget = strtod(target, &end);
+            if (mode == "peak") gNormalizeMode = kNormalizePeak;
+            else if (mode == "lufs") gNormalizeMode = kNormalizeLoudness;
+            if (gNormalizeMode == kNormalizeNone || end == target || *end != '\0') {
+                cerr << "Unknown normalize target: " << value << endl;
+                return false;
+            }
+            gAnalyze = true;
+        } else if (arg == "--tails") {
+            if (!parseTailSpec(value)) {
+                cerr << "Invalid tail settings: " << value << endl;
+                return false;
+            }
+            gTails = true;
+        } else if (arg == "--snap") {
+            const string mode = "zero-crossing";
+            bool ok = (value.compare(0, mode.size(), mode) == 0);
+            gSnapFrames = kDefaultSnapFrames;
+            if (ok && value.size() > mode.size()) {
+                const char* window = value.c_str() + mode.size() + 1;
+                char* end = nullptr;
+                gSnapFrames = (int)strtol(window, &end, 10);
+                ok = (value[mode.size()] == ':' && end != window && *end == '\0' && gSnapFrames > 0);
+            }
+            if (!ok) {
+                cerr << "Unknown snap mode: " << value << endl;
+                return false;
+            }
+            gSnapZeroCrossing = true;
+        } else if (arg == "--latency") {
+            if (value == "auto") gLatencyMode = kLatencyAuto;
+            else if (value == "auto-slice") gLatencyMode = kLatencyPerSlice;
+            else {
+                char* end = nullptr;
+                long frames = strtol(value.c_str(), &end, 10);
+                if (end == value.c_str() || *end != '\0') {
+                    cerr << "Unknown latency: " << value << endl;
+                    return false;
+                }
+                gLatencyMode = kLatencyFixed;
+                gLatencyFrames = (int)frames;
+            }
+        } else if (arg == "--verbosity") {
+            if (value == "silent") gVerbosity = kVerbositySilent;
+            else if (value == "summary") gVerbosity = kVerbositySummary;
+            else if (value == "debug") gVerbosity = kVerbosityDebug;
+            else {
+                cerr << "Unknown verbosity: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--jobs") {
+            opts.jobs = atoi(value.c_str());
+            if (opts.jobs <= 0) {
+                opts.jobs = (int)thread::hardware_concurrency();
+                if (opts.jobs <= 0) opts.jobs = 1;
+            }
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Main Program: Extract metadata and render full loop using preview API
+// ---------------------------------------------------------------------
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseOptions(argc, argv, opts)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    bool batchMode = !opts.batchManifest.empty();
+    bool serveMode = !opts.serveEndpoint.empty();
+    bool benchMode = !opts.benchBatchSizes.empty();
+    bool streamMode = (gStreamTarget != kStreamNone);
+    bool probeMode = opts.probe;
+    size_t expectedPositional = (batchMode || serveMode) ? 1 : ((benchMode || streamMode) ? 2 : 4);
+    bool positionalOk = probeMode ? opts.positional.size() >= 2 : opts.positional.size() == expectedPositional;
+    if ((batchMode + serveMode + benchMode + streamMode + probeMode) > 1 || !positionalOk) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (streamMode && (gSliceMode || gRenderTempos.size() > 1 || !gCacheDir.empty() || gWriteOT || gWriteXRNI
+                       || gTrim || !opts.metaPath.empty())) {
+        cerr << "--stream writes a single loop and its metadata; it can't be combined with"
+             << " --slices, several tempos, --cache, --ot, --xrni, --trim or --meta" << endl;
+        return 1;
+    }
+    // Console text must not end up in the data stream or between the
+    // probe records
+    streambuf* stdoutBuffer = cout.rdbuf();
+    if (gStreamTarget == kStreamStdout || probeMode) cout.rdbuf(cerr.rdbuf());
+    if (gSliceMode && !gRenderTempos.empty()) {
+        cerr << "--tempo has no effect on --slices output" << endl;
+        return 1;
+    }
+    if (gSliceMode && (gWriteOT || gWriteXRNI)) {
+        cerr << "--ot and --xrni need the loop, not --slices output" << endl;
+        return 1;
+    }
+    if (gSliceMode && gSnapZeroCrossing) {
+        cerr << "--snap moves loop markers; --slices output has none" << endl;
+        return 1;
+    }
+    if (!openStatsOutputs()) {
+        return 1;
+    }
+    const char* sdkPath = opts.positional.back().c_str();
+    // Batch jobs are already spread over the workers; single runs use
+    // --jobs for the slice writers instead.
+    gSliceWriters = batchMode ? 1 : opts.jobs;
+
+    // Perform diagnostics on the provided SDK bundle
+    if (logDebug()) print_bundle_debug(sdkPath);
+
+    // Initialize the REX DLL/dynamic library.
+    // Note: REXInitializeDLL_DirPath for Windows expects a wide-character string.
+#if defined(_WIN32)
+    wstring sdkPathW = ConvertToWide(sdkPath);
+    REX::REXError initErr = REX::REXInitializeDLL_DirPath(sdkPathW.c_str());
+#else
+    REX::REXError initErr = REX::REXInitializeDLL_DirPath(sdkPath);
+#endif
+    if (logDebug()) cout << "REXInitializeDLL_DirPath returned: " << initErr << endl;
+    if (initErr != REX::kREXError_NoError) {
+        cerr << "DLL initialization failed." << endl;
+        return 1;
+    }
+
+    int exitCode = 0;
+    if (benchMode) {
+        exitCode = runRenderBatchBenchmark(opts.positional[0], opts.benchBatchSizes, 3);
+    } else if (serveMode) {
+        exitCode = runServer(opts.serveEndpoint);
+    } else if (streamMode) {
+        exitCode = runStream(opts.positional[0]);
+    } else if (probeMode) {
+        vector<string> probeArgs(opts.positional.begin(), opts.positional.end() - 1);
+        ostream records(stdoutBuffer);
+        exitCode = (runProbe(probeArgs, opts.jobs, records) == 0) ? 0 : 1;
+    } else if (batchMode) {
+        int failed = runBatch(opts.batchManifest, opts.jobs);
+        exitCode = (failed == 0) ? 0 : 1;
+    } else {
+        DecodeJob job = { opts.positional[0], opts.positional[1], opts.positional[2], opts.metaPath };
+        ostringstream jobLog;
+        REX::REXError err = withJobStats(job.rx2Path, [&]() { return decodeJob(job, jobLog); });
+        exitCode = (err == REX::kREXError_NoError) ? 0 : 1;
+        cout << jobLog.str();
+    }
+
+    // Cleanup
+    REX::REXUninitializeDLL();
+    if (!writeTraceFile()) exitCode = 1;
+
+    return exitCode;
+}
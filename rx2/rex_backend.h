@@ -0,0 +1,54 @@
+// rex_backend.h
+//
+// Function table through which a backend library provides the REX API to
+// rex2decoder on platforms that have no REX Shared Library (Linux). A
+// backend is a shared library exporting
+//
+//   extern "C" const REXBackend* rex_backend_entry(void);
+//
+// rex_backend_loader.cpp dlopen()s the backend when the decoder calls
+// REXInitializeDLL_DirPath and forwards every REX:: call through this
+// table. stub/REXStub.cpp built with -DREX_STUB_BACKEND is one such
+// backend; a Wine bridge around the Windows DLL would be another.
+
+#ifndef REX_BACKEND_H
+#define REX_BACKEND_H
+
+#include "REX.h"
+
+#define REX_BACKEND_VERSION 1
+#define REX_BACKEND_ENTRY "rex_backend_entry"
+#define REX_BACKEND_DEFAULT_NAME "librexbackend.so"
+
+struct REXBackend {
+    int fVersion;       // REX_BACKEND_VERSION the backend was built against
+    int fSize;          // sizeof(REXBackend), for forward compatibility
+
+    REX::REXError (*fInitializeDLL_DirPath)(const char* dirPath);
+    void (*fUninitializeDLL)();
+
+    REX::REXError (*fCreate)(REX::REXHandle* handle, const char buffer[], REX::REX_int32_t size,
+                             REX::REXCreateCallback callbackFunc, void* userData);
+    void (*fDelete)(REX::REXHandle* handle);
+
+    REX::REXError (*fGetInfo)(REX::REXHandle handle, REX::REX_int32_t infoSize, REX::REXInfo* info);
+    REX::REXError (*fGetInfoFromBuffer)(REX::REX_int32_t bufferSize, const char buffer[],
+                                        REX::REX_int32_t infoSize, REX::REXInfo* info);
+    REX::REXError (*fGetCreatorInfo)(REX::REXHandle handle, REX::REX_int32_t infoSize, REX::REXCreatorInfo* info);
+    REX::REXError (*fGetSliceInfo)(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                   REX::REX_int32_t infoSize, REX::REXSliceInfo* info);
+
+    REX::REXError (*fSetOutputSampleRate)(REX::REXHandle handle, REX::REX_int32_t outputSampleRate);
+    REX::REXError (*fRenderSlice)(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                  REX::REX_int32_t bufferFrameLength, float* outputBuffers[2]);
+
+    REX::REXError (*fStartPreview)(REX::REXHandle handle);
+    REX::REXError (*fStopPreview)(REX::REXHandle handle);
+    REX::REXError (*fRenderPreviewBatch)(REX::REXHandle handle, REX::REX_int32_t framesToRender,
+                                         float* outputBuffers[2]);
+    REX::REXError (*fSetPreviewTempo)(REX::REXHandle handle, REX::REX_int32_t tempo);
+};
+
+typedef const REXBackend* (*REXBackendEntryProc)();
+
+#endif // REX_BACKEND_H
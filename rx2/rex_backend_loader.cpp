@@ -0,0 +1,126 @@
+// rex_backend_loader.cpp
+//
+// REX API implementation for the native Linux build: loads a backend
+// library (see rex_backend.h) at REXInitializeDLL_DirPath time and
+// forwards every call to it. This takes the place of the SDK's REX.c,
+// which does the same for the macOS bundle and the Windows DLL.
+//
+// The backend is looked up in this order:
+//   1. $REX_BACKEND, if set
+//   2. dirPath itself, if it names a file
+//   3. dirPath/librexbackend.so
+
+#include "rex_backend.h"
+
+#include <cstdlib>
+#include <string>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+namespace REX {
+
+static void* gBackendLibrary = nullptr;
+static const REXBackend* gBackend = nullptr;
+
+static std::string backendPath(const char* dirPath) {
+    const char* env = getenv("REX_BACKEND");
+    if (env != nullptr && env[0] != '\0') return env;
+    std::string path = (dirPath != nullptr) ? dirPath : ".";
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) return path;
+    if (!path.empty() && path.back() != '/') path += '/';
+    return path + REX_BACKEND_DEFAULT_NAME;
+}
+
+static void unloadBackend() {
+    if (gBackendLibrary != nullptr) dlclose(gBackendLibrary);
+    gBackendLibrary = nullptr;
+    gBackend = nullptr;
+}
+
+REXError REXInitializeDLL_DirPath(const char* dirPath) {
+    if (gBackend != nullptr) return kREXImplError_DLLAlreadyLoaded;
+    gBackendLibrary = dlopen(backendPath(dirPath).c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (gBackendLibrary == nullptr) return kREXError_DLLNotFound;
+    REXBackendEntryProc entry = (REXBackendEntryProc)dlsym(gBackendLibrary, REX_BACKEND_ENTRY);
+    const REXBackend* backend = (entry != nullptr) ? entry() : nullptr;
+    if (backend == nullptr) {
+        unloadBackend();
+        return kREXError_UnableToLoadDLL;
+    }
+    if (backend->fVersion != REX_BACKEND_VERSION || backend->fSize < (int)sizeof(REXBackend)) {
+        unloadBackend();
+        return kREXError_DLLTooOld;
+    }
+    gBackend = backend;
+    REXError err = gBackend->fInitializeDLL_DirPath(dirPath);
+    if (err != kREXError_NoError) unloadBackend();
+    return err;
+}
+
+void REXUninitializeDLL() {
+    if (gBackend == nullptr) return;
+    gBackend->fUninitializeDLL();
+    unloadBackend();
+}
+
+REXError REXCreate(REXHandle* handle, const char buffer[], REX_int32_t size, REXCreateCallback callbackFunc, void* userData) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fCreate(handle, buffer, size, callbackFunc, userData);
+}
+
+void REXDelete(REXHandle* handle) {
+    if (gBackend != nullptr) gBackend->fDelete(handle);
+}
+
+REXError REXGetInfo(REXHandle handle, REX_int32_t infoSize, REXInfo* info) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fGetInfo(handle, infoSize, info);
+}
+
+REXError REXGetInfoFromBuffer(REX_int32_t bufferSize, const char buffer[], REX_int32_t infoSize, REXInfo* info) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fGetInfoFromBuffer(bufferSize, buffer, infoSize, info);
+}
+
+REXError REXGetCreatorInfo(REXHandle handle, REX_int32_t infoSize, REXCreatorInfo* info) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fGetCreatorInfo(handle, infoSize, info);
+}
+
+REXError REXGetSliceInfo(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t infoSize, REXSliceInfo* info) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fGetSliceInfo(handle, sliceIndex, infoSize, info);
+}
+
+REXError REXSetOutputSampleRate(REXHandle handle, REX_int32_t outputSampleRate) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fSetOutputSampleRate(handle, outputSampleRate);
+}
+
+REXError REXRenderSlice(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t bufferFrameLength, float* outputBuffers[2]) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fRenderSlice(handle, sliceIndex, bufferFrameLength, outputBuffers);
+}
+
+REXError REXStartPreview(REXHandle handle) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fStartPreview(handle);
+}
+
+REXError REXStopPreview(REXHandle handle) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fStopPreview(handle);
+}
+
+REXError REXRenderPreviewBatch(REXHandle handle, REX_int32_t framesToRender, float* outputBuffers[2]) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fRenderPreviewBatch(handle, framesToRender, outputBuffers);
+}
+
+REXError REXSetPreviewTempo(REXHandle handle, REX_int32_t tempo) {
+    if (gBackend == nullptr) return kREXImplError_DLLNotLoaded;
+    return gBackend->fSetPreviewTempo(handle, tempo);
+}
+
+} // namespace REX
@@ -0,0 +1,106 @@
+// REX.h (stub backend)
+//
+// Stand-in for the REX SDK header, declaring only the part of the REX API
+// that rex2decoder uses. Building with -I stub and REXStub.cpp instead of
+// the SDK's REX.c links the decoder against a deterministic local REX
+// implementation, so it can be built, run and benchmarked on hosts that
+// have no REX Shared Library (see build_stub.sh).
+
+#ifndef REX_STUB_H
+#define REX_STUB_H
+
+#include <cstdint>
+
+namespace REX {
+
+#ifndef REX_TYPES_DEFINED
+typedef int32_t REX_int32_t;
+#endif
+
+enum REXError {
+    kREXError_NoError = 0,
+    kREXError_OperationAbortedByUser = 1,
+    kREXError_NoCreatorInfoAvailable = 2,
+
+    kREXError_NotEnoughMemoryForDLL = 100,
+    kREXError_UnableToLoadDLL = 101,
+    kREXError_DLLTooOld = 102,
+    kREXError_DLLNotFound = 103,
+    kREXError_APITooOld = 104,
+    kREXError_OutOfMemory = 105,
+    kREXError_FileCorrupt = 106,
+    kREXError_REX2FileTooNew = 107,
+    kREXError_FileHasZeroLoopLength = 108,
+    kREXError_OSVersionNotSupported = 109,
+
+    kREXImplError_DLLNotLoaded = 200,
+    kREXImplError_DLLAlreadyLoaded = 201,
+    kREXImplError_InvalidHandle = 202,
+    kREXImplError_InvalidSize = 203,
+    kREXImplError_InvalidArgument = 204,
+    kREXImplError_InvalidSlice = 205,
+    kREXImplError_InvalidSampleRate = 206,
+    kREXImplError_BufferTooSmall = 207,
+    kREXImplError_IsBeingPreviewed = 208,
+    kREXImplError_NotBeingPreviewed = 209,
+    kREXImplError_InvalidTempo = 210,
+
+    kREXError_Undefined = 666
+};
+
+typedef struct REXOpaqueHandle* REXHandle;
+
+struct REXInfo {
+    REX_int32_t fChannels;
+    REX_int32_t fSampleRate;
+    REX_int32_t fSliceCount;
+    REX_int32_t fTempo;          // BPM * 1000
+    REX_int32_t fOriginalTempo;  // BPM * 1000
+    REX_int32_t fPPQLength;      // 15360 PPQ per quarter note
+    REX_int32_t fTimeSignNom;
+    REX_int32_t fTimeSignDenom;
+    REX_int32_t fBitDepth;
+};
+
+struct REXSliceInfo {
+    REX_int32_t fPPQPos;
+    REX_int32_t fSampleLength;
+};
+
+struct REXCreatorInfo {
+    char fName[256];
+    char fCopyright[256];
+    char fURL[256];
+    char fEmail[256];
+    char fFreeText[256];
+};
+
+enum REXCallbackResult {
+    kREXCallback_Abort = 1,
+    kREXCallback_Continue = 2
+};
+
+typedef REXCallbackResult (*REXCreateCallback)(REX_int32_t percentFinished, void* userData);
+
+REXError REXInitializeDLL_DirPath(const char* dirPath);
+void REXUninitializeDLL();
+
+REXError REXCreate(REXHandle* handle, const char buffer[], REX_int32_t size, REXCreateCallback callbackFunc, void* userData);
+void REXDelete(REXHandle* handle);
+
+REXError REXGetInfo(REXHandle handle, REX_int32_t infoSize, REXInfo* info);
+REXError REXGetInfoFromBuffer(REX_int32_t bufferSize, const char buffer[], REX_int32_t infoSize, REXInfo* info);
+REXError REXGetCreatorInfo(REXHandle handle, REX_int32_t infoSize, REXCreatorInfo* info);
+REXError REXGetSliceInfo(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t infoSize, REXSliceInfo* info);
+
+REXError REXSetOutputSampleRate(REXHandle handle, REX_int32_t outputSampleRate);
+REXError REXRenderSlice(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t bufferFrameLength, float* outputBuffers[2]);
+
+REXError REXStartPreview(REXHandle handle);
+REXError REXStopPreview(REXHandle handle);
+REXError REXRenderPreviewBatch(REXHandle handle, REX_int32_t framesToRender, float* outputBuffers[2]);
+REXError REXSetPreviewTempo(REXHandle handle, REX_int32_t tempo);
+
+} // namespace REX
+
+#endif // REX_STUB_H
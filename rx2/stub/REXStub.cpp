@@ -0,0 +1,328 @@
+// REXStub.cpp
+//
+// Deterministic stand-in for the REX Shared Library. Instead of real
+// .rx2 data, REXCreate() takes a small text descriptor and synthesizes a
+// loop from it: every slice is a decaying sine burst whose pitch depends
+// on the slice index, so slice starts are sharp, repeatable transients.
+//
+// Descriptor format (one setting per line, '#' starts a comment):
+//
+//   REXSTUB 1
+//   channels 2
+//   samplerate 44100
+//   tempo 120000            # BPM * 1000
+//   originaltempo 120000    # defaults to tempo
+//   ppqlength 61440         # 15360 per quarter note
+//   timesig 4 4
+//   bitdepth 16
+//   latency 0               # preview output delay in frames
+//   slices 8                # N evenly spaced slices, or explicit lines:
+//   slice 0 11025           # PPQ position, length in source frames
+//   creator name Some Name  # name, copyright, url, email, freetext
+//
+// Preview rendering follows the SDK's timing model: at output rate R and
+// preview tempo T, one PPQ unit lasts R * 1000 / (T * 256) frames and the
+// loop repeats every fPPQLength units.
+
+#include "REX.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace REX {
+
+struct REXOpaqueHandle {
+    REXInfo info;                       // as described, at the source rate
+    REXCreatorInfo creator;
+    bool hasCreator = false;
+    vector<REXSliceInfo> slices;        // lengths in source frames
+    int latency = 0;
+    int outputRate = 0;
+    int previewTempo = 0;
+    bool previewing = false;
+    long long previewFrame = 0;
+};
+
+static atomic<bool> gInitialized(false);
+
+static const double kTwoPi = 6.283185307179586;
+
+REXError REXInitializeDLL_DirPath(const char*) {
+    bool expected = false;
+    if (!gInitialized.compare_exchange_strong(expected, true)) {
+        return kREXImplError_DLLAlreadyLoaded;
+    }
+    return kREXError_NoError;
+}
+
+void REXUninitializeDLL() {
+    gInitialized = false;
+}
+
+static void copyField(char* field, const string& text) {
+    strncpy(field, text.c_str(), 255);
+    field[255] = '\0';
+}
+
+static REXError parseDescriptor(const char buffer[], REX_int32_t size, REXOpaqueHandle& h) {
+    istringstream in(string(buffer, buffer + size));
+    string line;
+    if (!getline(in, line) || line.compare(0, 9, "REXSTUB 1") != 0) {
+        return kREXError_FileCorrupt;
+    }
+
+    memset(&h.info, 0, sizeof(h.info));
+    memset(&h.creator, 0, sizeof(h.creator));
+    h.info.fChannels = 2;
+    h.info.fSampleRate = 44100;
+    h.info.fTempo = 120000;
+    h.info.fPPQLength = 4 * 15360;
+    h.info.fTimeSignNom = 4;
+    h.info.fTimeSignDenom = 4;
+    h.info.fBitDepth = 16;
+    int evenSlices = 0;
+
+    while (getline(in, line)) {
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+        istringstream fields(line);
+        string key;
+        if (!(fields >> key)) continue;
+        if (key == "channels") fields >> h.info.fChannels;
+        else if (key == "samplerate") fields >> h.info.fSampleRate;
+        else if (key == "tempo") fields >> h.info.fTempo;
+        else if (key == "originaltempo") fields >> h.info.fOriginalTempo;
+        else if (key == "ppqlength") fields >> h.info.fPPQLength;
+        else if (key == "timesig") fields >> h.info.fTimeSignNom >> h.info.fTimeSignDenom;
+        else if (key == "bitdepth") fields >> h.info.fBitDepth;
+        else if (key == "latency") fields >> h.latency;
+        else if (key == "slices") fields >> evenSlices;
+        else if (key == "slice") {
+            REXSliceInfo slice;
+            if (!(fields >> slice.fPPQPos >> slice.fSampleLength)) return kREXError_FileCorrupt;
+            h.slices.push_back(slice);
+        } else if (key == "creator") {
+            string which, text;
+            fields >> which;
+            getline(fields >> ws, text);
+            h.hasCreator = true;
+            if (which == "name") copyField(h.creator.fName, text);
+            else if (which == "copyright") copyField(h.creator.fCopyright, text);
+            else if (which == "url") copyField(h.creator.fURL, text);
+            else if (which == "email") copyField(h.creator.fEmail, text);
+            else if (which == "freetext") copyField(h.creator.fFreeText, text);
+        } else {
+            return kREXError_FileCorrupt;
+        }
+    }
+
+    if (h.info.fChannels < 1 || h.info.fChannels > 2 || h.info.fSampleRate <= 0 || h.info.fTempo <= 0) {
+        return kREXError_FileCorrupt;
+    }
+    if (h.info.fPPQLength <= 0) {
+        return kREXError_FileHasZeroLoopLength;
+    }
+    if (h.info.fOriginalTempo == 0) h.info.fOriginalTempo = h.info.fTempo;
+
+    if (h.slices.empty() && evenSlices > 0) {
+        double loopFrames = (double)h.info.fSampleRate * 1000.0 * h.info.fPPQLength / (h.info.fTempo * 256.0);
+        for (int i = 0; i < evenSlices; i++) {
+            REXSliceInfo slice;
+            slice.fPPQPos = (int)((long long)h.info.fPPQLength * i / evenSlices);
+            slice.fSampleLength = (int)(loopFrames / evenSlices);
+            h.slices.push_back(slice);
+        }
+    }
+    sort(h.slices.begin(), h.slices.end(),
+         [](const REXSliceInfo& a, const REXSliceInfo& b) { return a.fPPQPos < b.fPPQPos; });
+    h.info.fSliceCount = (REX_int32_t)h.slices.size();
+    h.outputRate = h.info.fSampleRate;
+    h.previewTempo = h.info.fTempo;
+    return kREXError_NoError;
+}
+
+// Slice length in frames at the current output rate
+static int outputSliceLength(const REXOpaqueHandle& h, int sliceIndex) {
+    return (int)llround((double)h.slices[sliceIndex].fSampleLength * h.outputRate / h.info.fSampleRate);
+}
+
+// Sample `frame` (at the output rate) of slice `sliceIndex`, channel `channel`
+static float slice_sample(const REXOpaqueHandle& h, int sliceIndex, int channel, long long frame) {
+    double t = (double)frame / h.outputRate;
+    double frequency = 110.0 * pow(2.0, (sliceIndex % 12) / 12.0) * (1 + (sliceIndex / 12) % 3);
+    double envelope = exp(-t / 0.08);
+    double phase = (channel == 0) ? 0.0 : 0.25 * kTwoPi;
+    return (float)(0.5 * envelope * sin(kTwoPi * frequency * t + phase));
+}
+
+REXError REXCreate(REXHandle* handle, const char buffer[], REX_int32_t size, REXCreateCallback callbackFunc, void* userData) {
+    if (handle == nullptr || buffer == nullptr) return kREXImplError_InvalidArgument;
+    *handle = nullptr;
+    if (!gInitialized) return kREXImplError_DLLNotLoaded;
+    REXOpaqueHandle* h = new REXOpaqueHandle();
+    REXError err = parseDescriptor(buffer, size, *h);
+    if (err != kREXError_NoError) {
+        delete h;
+        return err;
+    }
+    if (callbackFunc != nullptr && callbackFunc(100, userData) == kREXCallback_Abort) {
+        delete h;
+        return kREXError_OperationAbortedByUser;
+    }
+    *handle = h;
+    return kREXError_NoError;
+}
+
+void REXDelete(REXHandle* handle) {
+    if (handle == nullptr) return;
+    delete *handle;
+    *handle = nullptr;
+}
+
+REXError REXGetInfo(REXHandle handle, REX_int32_t infoSize, REXInfo* info) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (infoSize != (REX_int32_t)sizeof(REXInfo)) return kREXImplError_InvalidSize;
+    *info = handle->info;
+    info->fSampleRate = handle->outputRate;
+    return kREXError_NoError;
+}
+
+REXError REXGetInfoFromBuffer(REX_int32_t bufferSize, const char buffer[], REX_int32_t infoSize, REXInfo* info) {
+    if (infoSize != (REX_int32_t)sizeof(REXInfo)) return kREXImplError_InvalidSize;
+    REXOpaqueHandle h;
+    REXError err = parseDescriptor(buffer, bufferSize, h);
+    if (err == kREXError_NoError) *info = h.info;
+    return err;
+}
+
+REXError REXGetCreatorInfo(REXHandle handle, REX_int32_t infoSize, REXCreatorInfo* info) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (infoSize != (REX_int32_t)sizeof(REXCreatorInfo)) return kREXImplError_InvalidSize;
+    if (!handle->hasCreator) return kREXError_NoCreatorInfoAvailable;
+    *info = handle->creator;
+    return kREXError_NoError;
+}
+
+REXError REXGetSliceInfo(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t infoSize, REXSliceInfo* info) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (infoSize != (REX_int32_t)sizeof(REXSliceInfo)) return kREXImplError_InvalidSize;
+    if (sliceIndex < 0 || sliceIndex >= handle->info.fSliceCount) return kREXImplError_InvalidSlice;
+    info->fPPQPos = handle->slices[sliceIndex].fPPQPos;
+    info->fSampleLength = outputSliceLength(*handle, sliceIndex);
+    return kREXError_NoError;
+}
+
+REXError REXSetOutputSampleRate(REXHandle handle, REX_int32_t outputSampleRate) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (outputSampleRate < 11025 || outputSampleRate > 1000000) return kREXImplError_InvalidSampleRate;
+    if (handle->previewing) return kREXImplError_IsBeingPreviewed;
+    handle->outputRate = outputSampleRate;
+    return kREXError_NoError;
+}
+
+REXError REXRenderSlice(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t bufferFrameLength, float* outputBuffers[2]) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (sliceIndex < 0 || sliceIndex >= handle->info.fSliceCount) return kREXImplError_InvalidSlice;
+    if (outputBuffers == nullptr || outputBuffers[0] == nullptr) return kREXImplError_InvalidArgument;
+    if (handle->info.fChannels == 2 && outputBuffers[1] == nullptr) return kREXImplError_InvalidArgument;
+    if (bufferFrameLength < outputSliceLength(*handle, sliceIndex)) return kREXImplError_BufferTooSmall;
+    int length = outputSliceLength(*handle, sliceIndex);
+    for (int c = 0; c < handle->info.fChannels; c++) {
+        for (int f = 0; f < bufferFrameLength; f++) {
+            outputBuffers[c][f] = (f < length) ? slice_sample(*handle, sliceIndex, c, f) : 0.0f;
+        }
+    }
+    return kREXError_NoError;
+}
+
+REXError REXStartPreview(REXHandle handle) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (handle->previewing) return kREXImplError_IsBeingPreviewed;
+    handle->previewing = true;
+    handle->previewFrame = 0;
+    return kREXError_NoError;
+}
+
+REXError REXStopPreview(REXHandle handle) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (!handle->previewing) return kREXImplError_NotBeingPreviewed;
+    handle->previewing = false;
+    return kREXError_NoError;
+}
+
+REXError REXRenderPreviewBatch(REXHandle handle, REX_int32_t framesToRender, float* outputBuffers[2]) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (!handle->previewing) return kREXImplError_NotBeingPreviewed;
+    if (framesToRender < 0 || outputBuffers == nullptr || outputBuffers[0] == nullptr) return kREXImplError_InvalidArgument;
+    if (handle->info.fChannels == 2 && outputBuffers[1] == nullptr) return kREXImplError_InvalidArgument;
+
+    const REXOpaqueHandle& h = *handle;
+    double framesPerPPQ = (double)h.outputRate * 1000.0 / ((double)h.previewTempo * 256.0);
+    double loopFrames = framesPerPPQ * h.info.fPPQLength;
+    for (int f = 0; f < framesToRender; f++) {
+        long long frame = handle->previewFrame + f - h.latency;
+        float values[2] = {0.0f, 0.0f};
+        if (frame >= 0 && !h.slices.empty()) {
+            double loopFrame = fmod((double)frame, loopFrames);
+            double ppq = loopFrame / framesPerPPQ;
+            // Last slice starting at or before this position
+            int s = (int)(upper_bound(h.slices.begin(), h.slices.end(), ppq,
+                                      [](double pos, const REXSliceInfo& slice) { return pos < slice.fPPQPos; })
+                          - h.slices.begin()) - 1;
+            if (s >= 0) {
+                long long offset = (long long)(loopFrame - h.slices[s].fPPQPos * framesPerPPQ);
+                if (offset < outputSliceLength(h, s)) {
+                    for (int c = 0; c < h.info.fChannels; c++) values[c] = slice_sample(h, s, c, offset);
+                }
+            }
+        }
+        for (int c = 0; c < h.info.fChannels; c++) outputBuffers[c][f] = values[c];
+    }
+    handle->previewFrame += framesToRender;
+    return kREXError_NoError;
+}
+
+REXError REXSetPreviewTempo(REXHandle handle, REX_int32_t tempo) {
+    if (handle == nullptr) return kREXImplError_InvalidHandle;
+    if (tempo < 20000 || tempo > 450000) return kREXImplError_InvalidTempo;
+    handle->previewTempo = tempo;
+    return kREXError_NoError;
+}
+
+} // namespace REX
+
+#if defined(REX_STUB_BACKEND)
+// Built as a shared library (build_linux.sh), the stub doubles as a
+// backend for rex_backend_loader.cpp.
+#include "../rex_backend.h"
+
+static const REXBackend kStubBackend = {
+    REX_BACKEND_VERSION,
+    (int)sizeof(REXBackend),
+    REX::REXInitializeDLL_DirPath,
+    REX::REXUninitializeDLL,
+    REX::REXCreate,
+    REX::REXDelete,
+    REX::REXGetInfo,
+    REX::REXGetInfoFromBuffer,
+    REX::REXGetCreatorInfo,
+    REX::REXGetSliceInfo,
+    REX::REXSetOutputSampleRate,
+    REX::REXRenderSlice,
+    REX::REXStartPreview,
+    REX::REXStopPreview,
+    REX::REXRenderPreviewBatch,
+    REX::REXSetPreviewTempo
+};
+
+extern "C" __attribute__((visibility("default"))) const REXBackend* rex_backend_entry() {
+    return &kStubBackend;
+}
+#endif
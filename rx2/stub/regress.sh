@@ -0,0 +1,279 @@
+#!/bin/bash
+# Regression and benchmark runs of a stub-backed rex2decoder build against
+# stub/example.rx2stub. Used by build_stub.sh and build_linux.sh:
+#
+#   stub/regress.sh DECODER SDK_PATH test [--update]
+#   stub/regress.sh DECODER SDK_PATH bench
+#
+# test decodes the example in each mode below and compares a digest of
+# every output (WAV frame counts and cksum, slice marker txt, metadata
+# JSON, cksum of any other output) with stub/expected/<mode>.txt. The
+# checks below run the other entry points (batch, server, stream, probe,
+# cache) and compare the digest of what they leave behind the same way;
+# a check also fails if what it verifies itself doesn't hold. Any
+# difference is printed and the run fails. --update rewrites the expected
+# files instead; only do that after checking that the change in output is
+# intended. stub/example.rex is a minimal REX1 AIFF (mono, 16 bit, three
+# slices) for the --native-rex path; the stub backend itself can't read
+# it.
+#
+# bench prints the preview render throughput per batch size and fails if
+# the batch sizes don't all render the same bytes.
+
+set -u
+
+if [ $# -lt 3 ]; then
+  echo "Usage: $0 DECODER SDK_PATH test [--update] | bench" >&2
+  exit 2
+fi
+
+here=$(cd "$(dirname "$0")" && pwd)
+decoder=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+sdk_path=$2
+action=$3
+update=0
+[ "${4:-}" = "--update" ] && update=1
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# mode|options
+modes=(
+  "default|"
+  "slices|--slices"
+  "format_s24|--format s24"
+  "format_f32|--format f32 --dither none"
+  "tempo|--tempo 90,140"
+  "sample_rate|--sample-rate 48000"
+  "render_batch|--render-batch 256"
+  "latency_auto|--latency auto"
+  "latency_auto_slice|--latency auto-slice"
+  "snap|--snap zero-crossing:128"
+  "tails|--tails -30"
+  "trim|--trim --tails -30"
+  "slices_trim|--slices --trim --tails -30"
+  "analyze|--analyze"
+  "normalize|--normalize lufs:-14"
+  "slices_normalize|--slices --normalize peak:-1"
+  "exports|--ot --xrni"
+)
+
+# check_<name> functions, each run in an empty $work/<name>
+checks=(
+  native_rex
+  native_rex_exports
+  batch
+  serve
+  stream
+  probe
+  cache
+  meta_binary
+)
+
+check_native_rex() {
+  cp "$here/example.rex" .
+  "$decoder" example.rex out.wav out.txt "$sdk_path" --native-rex --meta out.json > decode.log 2>&1
+}
+
+# --ot and --xrni need the loop's tempo, which the native REX1 path doesn't
+# know, so those jobs must go to the SDK (and fail on the stub backend)
+# instead of writing exports with tempo 0.
+check_native_rex_exports() {
+  cp "$here/example.rex" .
+  "$decoder" example.rex out.wav out.txt "$sdk_path" --native-rex --ot --verbosity summary \
+    > decode.log 2>&1 && return 1
+  ! grep -q "Native REX1 parse" decode.log && [ ! -e out.ot ] || return 1
+  "$decoder" example.rex out.wav out.txt "$sdk_path" --native-rex --xrni > decode.log 2>&1 && return 1
+  [ ! -e out.xrni ]
+}
+
+# Three parallel jobs, one of them on the native REX1 path
+check_batch() {
+  cp "$here/example.rx2stub" "$here/example.rex" .
+  printf 'example.rx2stub\ta.wav\ta.txt\ta.json\nexample.rx2stub\tb.wav\tb.txt\nexample.rex\tc.wav\tc.txt\tc.json\n' > jobs.tsv
+  "$decoder" --batch jobs.tsv --jobs 3 --native-rex "$sdk_path" > decode.log 2>&1
+}
+
+# One frame: 4-byte little-endian length, then the payload
+send_frame() {
+  local n=${#1}
+  printf "$(printf '\\%03o' $((n & 255)) $((n >> 8 & 255)) $((n >> 16 & 255)) $((n >> 24 & 255)))" >&3
+  printf '%s' "$1" >&3
+}
+
+receive_frame() {
+  local n
+  n=$(dd bs=1 count=4 <&3 2> /dev/null | od -An -tu4 | tr -d ' ')
+  [ -n "$n" ] && dd bs=1 count="$n" <&3 2> /dev/null
+}
+
+# A job and QUIT over TCP, on a port picked at random
+check_serve() {
+  cp "$here/example.rx2stub" .
+  local port=$((20000 + RANDOM % 20000))
+  "$decoder" --serve "tcp:$port" "$sdk_path" > decode.log 2>&1 &
+  local server=$!
+  for _ in $(seq 50); do
+    { exec 3<> "/dev/tcp/127.0.0.1/$port"; } 2> /dev/null && break
+    sleep 0.1
+  done
+  if ! { true >&3; } 2> /dev/null; then
+    kill $server
+    return 1
+  fi
+  send_frame "$(printf 'example.rx2stub\tout.wav\tout.txt\tout.json')"
+  receive_frame > response.txt
+  send_frame QUIT
+  receive_frame > quit.txt
+  exec 3>&-
+  wait $server
+}
+
+# The stream goes to stdout and, on Linux, into a shared memory segment;
+# both start with the same WAVE chunk
+check_stream() {
+  cp "$here/example.rx2stub" .
+  "$decoder" --stream stdout example.rx2stub "$sdk_path" > out.stream 2> decode.log || return 1
+  [ -d /dev/shm ] && [ "$(uname)" = Linux ] || return 0
+  local name=rex2decoder_regress_$$
+  "$decoder" --stream "shm:$name" example.rx2stub "$sdk_path" >> decode.log 2>&1 || return 1
+  cmp -s -n 65536 "/dev/shm/$name" out.stream
+  local status=$?
+  rm -f "/dev/shm/$name"
+  return $status
+}
+
+check_probe() {
+  cp "$here/example.rx2stub" .
+  cp example.rx2stub second.rx2stub
+  "$decoder" --probe --jobs 2 example.rx2stub second.rx2stub "$sdk_path" > probe.json 2> decode.log &&
+    "$decoder" --probe --sample-rate 48000 example.rx2stub "$sdk_path" > probe_48k.json 2>> decode.log
+}
+
+# The second decode must come from the cache without rendering and give
+# the same outputs. Native REX1 decodes are never cached.
+check_cache() {
+  cp "$here/example.rx2stub" "$here/example.rex" .
+  "$decoder" example.rx2stub miss.wav miss.txt "$sdk_path" --cache cache --meta miss.json \
+    --stats miss.stats > decode.log 2>&1 &&
+    "$decoder" example.rx2stub hit.wav hit.txt "$sdk_path" --cache cache --meta hit.json \
+      --stats hit.stats >> decode.log 2>&1 || return 1
+  grep -q '"renderCalls": 0' hit.stats && cmp -s miss.wav hit.wav && cmp -s miss.txt hit.txt || return 1
+  "$decoder" example.rex rex.wav rex.txt "$sdk_path" --native-rex --cache rex_cache >> decode.log 2>&1 || return 1
+  [ -z "$(ls -A rex_cache 2> /dev/null)" ] || return 1
+  rm -rf cache rex_cache
+}
+
+# RX2M metadata written, read back from a cache entry and written again
+check_meta_binary() {
+  cp "$here/example.rx2stub" .
+  "$decoder" example.rx2stub out.wav out.txt "$sdk_path" --cache cache --meta-format binary \
+    --meta out.rx2m > decode.log 2>&1 &&
+    "$decoder" example.rx2stub hit.wav hit.txt "$sdk_path" --cache cache --meta-format binary \
+      --meta hit.rx2m >> decode.log 2>&1 || return 1
+  cmp -s out.rx2m hit.rx2m || return 1
+  rm -rf cache
+}
+
+# One line per WAV (data frames from the header, cksum of the whole file),
+# then the full text of every txt and json output. Names are relative to
+# the mode's directory, so the digest doesn't depend on where it ran.
+digest() {
+  local file
+  for file in $(ls | sort); do
+    case "$file" in
+      *.wav)
+        local data align
+        data=$(od -An -tu4 -j40 -N4 "$file" | tr -d ' ')
+        align=$(od -An -tu2 -j32 -N2 "$file" | tr -d ' ')
+        echo "wav $file frames $((data / align)) cksum $(cksum < "$file")"
+        ;;
+      *.txt|*.json)
+        echo "== $file"
+        cat "$file"
+        ;;
+      *.ot|*.xrni|*.rx2m|*.stream)
+        echo "file $file cksum $(cksum < "$file")"
+        ;;
+    esac
+  done
+}
+
+# Compares $work/$1.digest with stub/expected/$1.txt (or replaces it)
+compare_digest() {
+  local expected="$here/expected/$1.txt"
+  if [ $update -eq 1 ]; then
+    mkdir -p "$here/expected"
+    cp "$work/$1.digest" "$expected"
+    echo "UPDATED $1"
+  elif [ ! -f "$expected" ]; then
+    echo "FAIL $1: no $expected"
+    return 1
+  elif diff -u "$expected" "$work/$1.digest"; then
+    echo "PASS $1"
+  else
+    echo "FAIL $1"
+    return 1
+  fi
+  return 0
+}
+
+run_test() {
+  local failures=0 entry mode options
+  for entry in "${modes[@]}"; do
+    mode=${entry%%|*}
+    options=${entry#*|}
+    mkdir "$work/$mode"
+    cp "$here/example.rx2stub" "$work/$mode/"
+    # shellcheck disable=SC2086
+    if ! (cd "$work/$mode" && "$decoder" example.rx2stub out.wav out.txt "$sdk_path" \
+            $options --meta out.json > decode.log 2>&1); then
+      echo "FAIL $mode: decoder exited with an error"
+      cat "$work/$mode/decode.log"
+      failures=$((failures + 1))
+      continue
+    fi
+    (cd "$work/$mode" && digest) > "$work/$mode.digest"
+    compare_digest "$mode" || failures=$((failures + 1))
+  done
+  local check
+  for check in "${checks[@]}"; do
+    mkdir "$work/$check"
+    if ! (cd "$work/$check" && "check_$check"); then
+      echo "FAIL $check"
+      [ -f "$work/$check/decode.log" ] && cat "$work/$check/decode.log"
+      failures=$((failures + 1))
+      continue
+    fi
+    (cd "$work/$check" && digest) > "$work/$check.digest"
+    compare_digest "$check" || failures=$((failures + 1))
+  done
+  if [ $failures -ne 0 ]; then
+    echo "$failures of $((${#modes[@]} + ${#checks[@]})) modes and checks failed"
+    return 1
+  fi
+  return 0
+}
+
+run_bench() {
+  cp "$here/example.rx2stub" "$work/"
+  (cd "$work" && "$decoder" --bench-batch 64,256,1024,4096 example.rx2stub "$sdk_path") > "$work/bench.log" 2>&1
+  local status=$?
+  cat "$work/bench.log"
+  [ $status -eq 0 ] || return 1
+  # BENCH<TAB>batch<TAB>sdk calls<TAB>ms<TAB>frames/s<TAB>checksum<TAB>same|DIFFERENT
+  if awk -F'\t' '$1 == "BENCH" && $7 != "same" { bad = 1 } END { exit !bad }' "$work/bench.log"; then
+    echo "FAIL: batch sizes rendered different output"
+    return 1
+  fi
+  return 0
+}
+
+case "$action" in
+  test) run_test ;;
+  bench) run_bench ;;
+  *)
+    echo "Unknown action: $action" >&2
+    exit 2
+    ;;
+esac